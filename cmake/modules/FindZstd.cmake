@@ -0,0 +1,20 @@
+# Find zstd
+#
+#   ZSTD_INCLUDE_DIRS   - where to find zstd.h
+#   ZSTD_LIBRARIES      - List of libraries when using zstd.
+#   ZSTD_FOUND          - True if zstd found.
+
+find_path(ZSTD_INCLUDE_DIR NAMES zstd.h)
+mark_as_advanced(ZSTD_INCLUDE_DIR)
+
+find_library(ZSTD_LIBRARY NAMES zstd libzstd)
+mark_as_advanced(ZSTD_LIBRARY)
+
+include(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(Zstd
+    REQUIRED_VARS ZSTD_LIBRARY ZSTD_INCLUDE_DIR)
+
+if (ZSTD_FOUND)
+    set(ZSTD_LIBRARIES ${ZSTD_LIBRARY})
+    set(ZSTD_INCLUDE_DIRS ${ZSTD_INCLUDE_DIR})
+endif()
@@ -10,16 +10,50 @@
 
 #include <entwine/reader/cache.hpp>
 
+#include <chrono>
+#include <exception>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
 #include <entwine/reader/chunk-reader.hpp>
 #include <entwine/reader/reader.hpp>
+#include <entwine/types/chunk-stats.hpp>
+#include <entwine/types/format.hpp>
 #include <entwine/types/metadata.hpp>
 #include <entwine/types/schema.hpp>
-#include <entwine/util/pool.hpp>
+#include <entwine/util/json.hpp>
+#include <entwine/util/mapped-file.hpp>
 #include <entwine/util/unique.hpp>
 
 namespace entwine
 {
 
+namespace
+{
+    // Uncompressed chunks on the local filesystem may be mapped directly
+    // rather than read into memory.
+    bool isMappable(const Reader& reader)
+    {
+        return
+            !reader.metadata().format().compress() &&
+            reader.endpoint().isLocal();
+    }
+
+    std::size_t estimateBytes(const FetchInfo& f)
+    {
+        return ChunkReader::estimateBytes(
+                f.reader.metadata().schema(),
+                f.numPoints.getSimple(),
+                isMappable(f.reader));
+    }
+
+    const std::size_t fetchQueueSize(1024);
+    const std::size_t executorThreads(2);
+    const std::size_t minBytes(1024 * 1024);
+    const std::size_t numShards(64);
+}
+
 FetchInfo::FetchInfo(
         const Reader& reader,
         const Id& id,
@@ -68,24 +102,61 @@ DataChunkState::DataChunkState()
     : chunkReader()
     , inactiveIt()
     , refs(0)
+    , mapped(false)
+    , bytes(0)
+    , fetching()
+    , fetched()
     , mutex()
 { }
 
 DataChunkState::~DataChunkState() { }
 
+FetchStats::FetchStats()
+    : fetches(0)
+    , coalesced(0)
+    , totalMs(0)
+    , maxMs(0)
+{ }
 
 
 
 
-Cache::Cache(const std::size_t maxChunks)
-    : m_maxChunks(std::max<std::size_t>(maxChunks, 16))
-    , m_chunkManager()
-    , m_inactiveList()
-    , m_activeCount(0)
-    , m_mutex()
-    , m_cv()
+
+CacheShard::CacheShard()
+    : chunks()
+    , inactive()
+    , mutex()
 { }
 
+
+
+
+
+Cache::Cache(const Config& config)
+    : m_maxBytes(config.maxBytes)
+    , m_maxHierarchyBytes(config.maxHierarchyBytes)
+    , m_maxStatsBytes(config.maxStatsBytes)
+    , m_shards(numShards)
+    , m_admission(config.maxBytes)
+    , m_inactiveBytes(0)
+    , m_evictCursor(0)
+    , m_hierarchyCache()
+    , m_hierarchyMutex()
+    , m_statsCache()
+    , m_fetchStats()
+    , m_fetchStatsMutex()
+    , m_queryCache(config.maxQueryBytes)
+    , m_executor(executorThreads)
+    , m_fetchPool(config.fetchThreads, fetchQueueSize)
+{
+    // Anything smaller would admit every query alone, serializing them all.
+    if (m_maxBytes < minBytes)
+    {
+        throw std::runtime_error(
+                "Cache maxBytes must be at least " + std::to_string(minBytes));
+    }
+}
+
 std::unique_ptr<Block> Cache::acquire(
         const std::string& readerPath,
         const FetchInfoSet& fetches)
@@ -100,116 +171,252 @@ std::unique_ptr<Block> Cache::acquire(
     return block;
 }
 
-void Cache::release(const Block& block)
+void Cache::acquire(
+        const std::string& readerPath,
+        const FetchInfoSet& fetches,
+        Pool& executor,
+        const Acquired done)
 {
-    bool notify(false);
-    const std::string path(block.path());
+    // Shared by every stage of this acquisition.
+    struct State
+    {
+        std::unique_ptr<Block> block;
+        std::vector<Pending> pending;
+        std::atomic_size_t remaining;
+    };
 
-    std::unique_lock<std::mutex> lock(m_mutex);
+    const std::size_t admitted(cost(fetches));
 
-    LocalManager& localManager(m_chunkManager.at(path));
+    const auto finish([this, done](std::shared_ptr<State> state)
+    {
+        std::exception_ptr error;
+
+        try
+        {
+            if (!collect(state->pending, *state->block))
+            {
+                throw std::runtime_error("Invalid remote index state");
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        if (error) done(std::unique_ptr<Block>(), error);
+        else done(std::move(state->block), error);
+    });
+
+    const auto start(
+            [this, readerPath, fetches, admitted, &executor, done, finish]()
+    {
+        auto state(std::make_shared<State>());
+
+        try
+        {
+            state->block = reserved(readerPath, fetches, admitted);
+
+            // Hold one count ourselves, so our fetches can't finish before
+            // they've all been started.
+            state->remaining = fetches.size() + 1;
+
+            const auto fetched([state, &executor, finish]()
+            {
+                if (!--state->remaining)
+                {
+                    executor.post([state, finish]() { finish(state); });
+                }
+            });
+
+            for (const auto& f : fetches)
+            {
+                state->pending.emplace_back(
+                        f.id,
+                        fetch(readerPath, f, fetched));
+            }
+
+            fetched();
+        }
+        catch (...)
+        {
+            done(std::unique_ptr<Block>(), std::current_exception());
+        }
+    });
+
+    // Posted rather than added, since we may be called back on a thread
+    // that mustn't block: a fetch thread, or one of executor's own.
+    const auto admit([&executor, start, done](std::exception_ptr error)
+    {
+        if (error) done(std::unique_ptr<Block>(), error);
+        else executor.post(start);
+    });
+
+    m_admission.acquire(admitted, admit);
+}
+
+CacheShard& Cache::shard(const std::string& readerPath, const Id& id)
+{
+    const std::size_t h(
+            std::hash<std::string>()(readerPath) * 31 + std::hash<Id>()(id));
+
+    return m_shards[h % m_shards.size()];
+}
+
+void Cache::release(const Block& block)
+{
+    std::size_t freed(0);
+    const std::string path(block.path());
 
     for (const auto& c : block.chunkMap())
     {
         const Id& id(c.first);
 
-        std::unique_ptr<DataChunkState>& chunkState(localManager.at(id));
+        CacheShard& selected(shard(path, id));
+        std::lock_guard<std::mutex> lock(selected.mutex);
+
+        auto localIt(selected.chunks.find(path));
+        if (localIt == selected.chunks.end()) continue;
+
+        LocalManager& localManager(localIt->second);
+        auto stateIt(localManager.find(id));
+        if (stateIt == localManager.end()) continue;
+
+        std::unique_ptr<DataChunkState>& chunkState(stateIt->second);
 
         if (chunkState)
         {
             if (!--chunkState->refs)
             {
-                m_inactiveList.push_front(GlobalChunkInfo(path, id));
+                freed += chunkState->bytes;
+
+                selected.inactive.push_front(GlobalChunkInfo(path, id));
 
                 chunkState->inactiveIt.reset(
-                        new InactiveList::iterator(m_inactiveList.begin()));
+                        new InactiveList::iterator(selected.inactive.begin()));
 
-                --m_activeCount;
-                notify = true;
+                m_inactiveBytes += chunkState->bytes;
             }
         }
         else
         {
             std::cout << "Removing a bad fetch" << std::endl;
-            localManager.erase(id);
-            if (localManager.empty()) m_chunkManager.erase(path);
+            localManager.erase(stateIt);
         }
+
+        if (localManager.empty()) selected.chunks.erase(localIt);
     }
 
-    if (m_activeCount)
+    m_admission.release(freed);
+
+    if (const std::size_t active = m_admission.used())
     {
         std::cout <<
-            "\tActive size: " << m_activeCount <<
-            "\tIdle size: " << m_inactiveList.size() <<
+            "\tActive bytes: " << active <<
+            "\tIdle bytes: " << m_inactiveBytes <<
             "\tThis query: " << block.chunkMap().size() << std::endl;
     }
-
-    if (notify)
-    {
-        lock.unlock();
-        m_cv.notify_all();
-    }
 }
 
 std::unique_ptr<Block> Cache::reserve(
         const std::string& readerPath,
         const FetchInfoSet& fetches)
 {
-    if (m_activeCount > m_maxChunks)
-    {
-        throw std::runtime_error("Unexpected cache state");
-    }
+    const std::size_t admitted(cost(fetches));
+    m_admission.acquire(admitted);
+    return reserved(readerPath, fetches, admitted);
+}
 
-    std::unique_lock<std::mutex> lock(m_mutex);
-    m_cv.wait(lock, [this, &fetches]()->bool
-    {
-        return m_activeCount + fetches.size() <= m_maxChunks;
-    });
+std::size_t Cache::cost(const FetchInfoSet& fetches) const
+{
+    // This is only an estimate.  Some of these chunks may already be active
+    // for another query, and idle ones are charged at their actual size, so
+    // our holding is corrected once we know what we've charged.
+    std::size_t bytes(0);
+    for (const auto& f : fetches) bytes += estimateBytes(f);
+    return bytes;
+}
 
+std::unique_ptr<Block> Cache::reserved(
+        const std::string& readerPath,
+        const FetchInfoSet& fetches,
+        const std::size_t cost)
+{
     // Make the Block responsible for these chunks now, so even if something
     // throws during the fetching, we won't hold inactive reservations.
     std::unique_ptr<Block> block(new Block(*this, readerPath, fetches));
 
-    LocalManager& localManager(m_chunkManager[readerPath]);
+    std::size_t charged(0);
 
     // Reserve these fetches:
-    //      - Insert (sans actual data) into the GlobalManager if non-existent
+    //      - Insert (sans actual data) into its shard if non-existent
     //      - Increment the reference count - may be zero if inactive or new
     //      - If already existed and inactive, remove from the inactive list
     for (const auto& f : fetches)
     {
-        std::unique_ptr<DataChunkState>& chunkState(localManager[f.id]);
+        CacheShard& selected(shard(readerPath, f.id));
+        std::lock_guard<std::mutex> lock(selected.mutex);
+
+        std::unique_ptr<DataChunkState>& chunkState(
+                selected.chunks[readerPath][f.id]);
 
         if (!chunkState)
         {
             chunkState.reset(new DataChunkState());
-            ++m_activeCount;
+            chunkState->mapped = isMappable(f.reader);
+            chunkState->bytes = estimateBytes(f);
+            charged += chunkState->bytes;
         }
         else if (chunkState->inactiveIt)
         {
-            m_inactiveList.erase(*chunkState->inactiveIt);
+            selected.inactive.erase(*chunkState->inactiveIt);
             chunkState->inactiveIt.reset(nullptr);
-            ++m_activeCount;
+            m_inactiveBytes -= chunkState->bytes;
+            charged += chunkState->bytes;
         }
 
         ++chunkState->refs;
     }
 
+    m_admission.adjust(cost, charged);
+
     // Do the removal after the reservation so we don't remove anything we are
     // about to need to fetch.
-    while (m_activeCount + m_inactiveList.size() > m_maxChunks)
+    evict();
+
+    return block;
+}
+
+void Cache::evict()
+{
+    // Walk the shards round-robin, taking the least recently used idle chunk
+    // of each, until we fit or every shard has come up empty.
+    std::size_t misses(0);
+
+    while (
+            misses < m_shards.size() &&
+            m_admission.used() + m_inactiveBytes > m_maxBytes)
     {
-        const GlobalChunkInfo& toRemove(m_inactiveList.back());
+        CacheShard& selected(m_shards[m_evictCursor++ % m_shards.size()]);
+        std::lock_guard<std::mutex> lock(selected.mutex);
 
-        LocalManager& localManager(m_chunkManager.at(toRemove.path));
+        if (selected.inactive.empty())
+        {
+            ++misses;
+            continue;
+        }
+
+        misses = 0;
+
+        const GlobalChunkInfo& toRemove(selected.inactive.back());
+
+        LocalManager& localManager(selected.chunks.at(toRemove.path));
+        m_inactiveBytes -= localManager.at(toRemove.id)->bytes;
         localManager.erase(toRemove.id);
 
-        if (localManager.empty()) m_chunkManager.erase(toRemove.path);
+        if (localManager.empty()) selected.chunks.erase(toRemove.path);
 
-        m_inactiveList.pop_back();
+        selected.inactive.pop_back();
     }
-
-    return block;
 }
 
 bool Cache::populate(
@@ -217,56 +424,322 @@ bool Cache::populate(
         const FetchInfoSet& fetches,
         Block& block)
 {
-    bool success(true);
-    std::mutex mutex;
-    Pool pool(std::min<std::size_t>(2, fetches.size()));
+    std::vector<Pending> pending;
+    pending.reserve(fetches.size());
 
     for (const auto& f : fetches)
     {
-        pool.add([this, &readerPath, &f, &block, &mutex, &success]()->void
+        pending.emplace_back(f.id, fetch(readerPath, f));
+    }
+
+    return collect(pending, block);
+}
+
+bool Cache::collect(std::vector<Pending>& pending, Block& block)
+{
+    // Wait for every fetch, even after a failure, since outstanding fetches
+    // refer to chunk states that our Block keeps alive.
+    bool success(true);
+    std::exception_ptr error;
+
+    for (Pending& p : pending)
+    {
+        try
         {
-            if (const ChunkReader* chunkReader = fetch(readerPath, f))
+            if (const ChunkReader* chunkReader = p.second.get())
             {
-                std::lock_guard<std::mutex> lock(mutex);
-                block.set(f.id, chunkReader);
+                block.set(p.first, chunkReader);
             }
             else
             {
                 success = false;
             }
-        });
+        }
+        catch (...)
+        {
+            if (!error) error = std::current_exception();
+        }
     }
 
-    pool.join();
+    if (error) std::rethrow_exception(error);
 
     return success;
 }
 
-const ChunkReader* Cache::fetch(
+std::shared_future<const ChunkReader*> Cache::fetch(
         const std::string& readerPath,
-        const FetchInfo& fetchInfo)
+        const FetchInfo& fetchInfo,
+        const std::function<void()> fetched)
 {
-    std::unique_lock<std::mutex> globalLock(m_mutex);
-    DataChunkState& chunkState(*m_chunkManager.at(readerPath).at(fetchInfo.id));
-    globalLock.unlock();
+    CacheShard& selected(shard(readerPath, fetchInfo.id));
+
+    std::unique_lock<std::mutex> shardLock(selected.mutex);
+    LocalManager& localManager(selected.chunks.at(readerPath));
+    DataChunkState& chunkState(*localManager.at(fetchInfo.id));
+    shardLock.unlock();
 
-    std::lock_guard<std::mutex> lock(chunkState.mutex);
+    std::unique_lock<std::mutex> lock(chunkState.mutex);
 
-    if (!chunkState.chunkReader)
+    if (chunkState.fetching.valid())
     {
-        const Reader& reader(fetchInfo.reader);
-        const Metadata& metadata(reader.metadata());
-        const std::string path(metadata.structure().maybePrefix(fetchInfo.id));
+        std::shared_future<const ChunkReader*> result(chunkState.fetching);
+
+        if (!chunkState.chunkReader)
+        {
+            std::lock_guard<std::mutex> statsLock(m_fetchStatsMutex);
+            ++m_fetchStats.coalesced;
+
+            if (fetched) chunkState.fetched.push_back(fetched);
+        }
+        else if (fetched)
+        {
+            // Our result may not quite be ready, but it's about to be.
+            lock.unlock();
+            fetched();
+        }
+
+        return result;
+    }
+
+    using Promise = std::promise<const ChunkReader*>;
+    auto promise(std::make_shared<Promise>());
+
+    chunkState.fetching = promise->get_future().share();
+    std::shared_future<const ChunkReader*> result(chunkState.fetching);
+
+    if (fetched) chunkState.fetched.push_back(fetched);
+
+    lock.unlock();
+
+    const auto task([this, fetchInfo, &selected, &chunkState, promise]()
+    {
+        const auto start(std::chrono::steady_clock::now());
+
+        // Our chunk state may not outlive our promise, so these are taken
+        // along with our result and run once it's set.
+        std::vector<std::function<void()>> fetched;
+
+        try
+        {
+            std::unique_ptr<ChunkReader> chunkReader(
+                    load(fetchInfo, chunkState.mapped));
+
+            const ChunkReader* raw(chunkReader.get());
+            const std::size_t bytes(raw->bytes());
+
+            std::unique_lock<std::mutex> lock(chunkState.mutex);
+            chunkState.chunkReader = std::move(chunkReader);
+            fetched.swap(chunkState.fetched);
+            lock.unlock();
+
+            // Replace our estimate with the actual size, and record whether
+            // we were really mapped, since mapping may have failed.
+            std::unique_lock<std::mutex> shardLock(selected.mutex);
+            const std::size_t estimate(chunkState.bytes);
+            chunkState.bytes = bytes;
+            chunkState.mapped = raw->mapped();
+            shardLock.unlock();
+
+            m_admission.adjust(estimate, bytes);
+
+            const double ms(
+                    std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start).count());
+
+            std::unique_lock<std::mutex> statsLock(m_fetchStatsMutex);
+            ++m_fetchStats.fetches;
+            m_fetchStats.totalMs += ms;
+            m_fetchStats.maxMs = std::max(m_fetchStats.maxMs, ms);
+            statsLock.unlock();
+
+            promise->set_value(raw);
+        }
+        catch (...)
+        {
+            // Let a later request retry this chunk.
+            std::unique_lock<std::mutex> lock(chunkState.mutex);
+            chunkState.fetching = std::shared_future<const ChunkReader*>();
+            fetched.insert(
+                    fetched.end(),
+                    chunkState.fetched.begin(),
+                    chunkState.fetched.end());
+            chunkState.fetched.clear();
+            lock.unlock();
+
+            promise->set_exception(std::current_exception());
+        }
 
-        chunkState.chunkReader = makeUnique<ChunkReader>(
+        for (const auto& f : fetched) f();
+    });
+
+    // An asynchronous caller runs on its executor, which must never wait on
+    // our queue, so it posts.  A synchronous caller is throttled by it.
+    if (fetched) m_fetchPool.post(task);
+    else m_fetchPool.add(task);
+
+    return result;
+}
+
+std::unique_ptr<ChunkReader> Cache::load(
+        const FetchInfo& fetchInfo,
+        const bool mapped)
+{
+    const Reader& reader(fetchInfo.reader);
+    const Metadata& metadata(reader.metadata());
+    const arbiter::Endpoint& endpoint(reader.endpoint());
+    const std::string path(metadata.structure().maybePrefix(fetchInfo.id));
+
+    std::unique_ptr<MappedFile> mapping;
+
+    if (mapped)
+    {
+        mapping = MappedFile::tryMap(
+                arbiter::fs::expandTilde(endpoint.fullPath(path)));
+    }
+
+    if (mapping)
+    {
+        return makeUnique<ChunkReader>(
+                metadata,
+                fetchInfo.id,
+                fetchInfo.depth,
+                std::move(mapping));
+    }
+    else
+    {
+        return makeUnique<ChunkReader>(
                 metadata,
                 fetchInfo.id,
                 fetchInfo.depth,
-                makeUnique<std::vector<char>>(
-                    reader.endpoint().getBinary(path)));
+                makeUnique<std::vector<char>>(endpoint.getBinary(path)));
     }
+}
 
-    return chunkState.chunkReader.get();
+std::vector<std::shared_ptr<const ChunkStats>> Cache::stats(
+        const Reader& reader,
+        const std::vector<Id>& chunkIds)
+{
+    using Stats = std::shared_ptr<const ChunkStats>;
+
+    const std::string readerPath(reader.path());
+    std::vector<Stats> result(chunkIds.size());
+
+    // Indices into chunkIds of those we need to fetch.
+    std::vector<std::pair<std::size_t, std::future<Stats>>> pending;
+
+    auto& entries(m_statsCache.entries);
+    auto& order(m_statsCache.order);
+
+    std::unique_lock<std::mutex> lock(m_statsCache.mutex);
+
+    for (std::size_t i(0); i < chunkIds.size(); ++i)
+    {
+        const auto it(entries.find(StatsKey(readerPath, chunkIds[i])));
+
+        if (it != entries.end())
+        {
+            order.splice(order.end(), order, it->second.it);
+            result[i] = it->second.stats;
+        }
+        else
+        {
+            pending.emplace_back(i, std::future<Stats>());
+        }
+    }
+
+    lock.unlock();
+
+    std::exception_ptr error;
+
+    try
+    {
+        for (auto& p : pending)
+        {
+            const Id id(chunkIds[p.first]);
+            auto promise(std::make_shared<std::promise<Stats>>());
+            p.second = promise->get_future();
+
+            m_fetchPool.add([&reader, id, promise]()
+            {
+                try
+                {
+                    const std::string path(
+                            ChunkStats::path(reader.metadata(), id));
+
+                    Stats stats;
+                    if (auto data = reader.endpoint().tryGet(path))
+                    {
+                        stats = std::make_shared<const ChunkStats>(
+                                parse(*data));
+                    }
+
+                    promise->set_value(stats);
+                }
+                catch (...)
+                {
+                    promise->set_exception(std::current_exception());
+                }
+            });
+        }
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    // Wait for everything submitted, even after a failure, since our fetches
+    // refer to the reader.
+    for (auto& p : pending)
+    {
+        if (!p.second.valid()) continue;
+
+        try
+        {
+            result[p.first] = p.second.get();
+        }
+        catch (...)
+        {
+            if (!error) error = std::current_exception();
+        }
+    }
+
+    if (error) std::rethrow_exception(error);
+
+    lock.lock();
+
+    for (const auto& p : pending)
+    {
+        const StatsKey key(readerPath, chunkIds[p.first]);
+
+        // If another query fetched these meanwhile, theirs are kept.
+        if (entries.count(key)) continue;
+
+        const Stats& stats(result[p.first]);
+        const std::size_t bytes(
+                sizeof(CachedStats) + 2 * sizeof(StatsKey) +
+                2 * readerPath.size() + (stats ? stats->bytes() : 0));
+
+        order.push_back(key);
+        const CachedStats cached{ stats, std::prev(order.end()), bytes };
+        entries.emplace(key, cached);
+        m_statsCache.bytes += bytes;
+    }
+
+    while (m_statsCache.bytes > m_maxStatsBytes && !order.empty())
+    {
+        const auto it(entries.find(order.front()));
+        m_statsCache.bytes -= it->second.bytes;
+        entries.erase(it);
+        order.pop_front();
+    }
+
+    return result;
+}
+
+FetchStats Cache::fetchStats() const
+{
+    std::lock_guard<std::mutex> lock(m_fetchStatsMutex);
+    return m_fetchStats;
 }
 
 void Cache::markHierarchy(
@@ -287,33 +760,43 @@ void Cache::markHierarchy(
 
     for (const Hierarchy::Slot* s : touched)
     {
-        if (slots.count(s))
+        auto it(slots.find(s));
+
+        if (it != slots.end())
         {
-            order.splice(order.begin(), order, slots.at(s));
+            order.splice(order.begin(), order, it->second.it);
         }
         else
         {
-            auto it(slots.insert(std::make_pair(s, order.end())).first);
+            std::size_t bytes(0);
+
+            {
+                SpinGuard spinLock(s->spinner);
+                if (s->t) bytes = s->t->bytes();
+            }
+
             order.push_front(s);
-            it->second = order.begin();
+            slots[s] = CachedSlot { order.begin(), bytes };
+            selected.bytes += bytes;
         }
     }
 
-    std::cout << "Awake for " << name << ": " << slots.size() << std::endl;
+    std::cout << "Awake for " << name << ": " << slots.size() << " blocks, " <<
+        selected.bytes << " bytes" << std::endl;
 
-    if (slots.size() > m_maxChunks)
-    {
-        std::cout << "Erasing " << (slots.size() - m_maxChunks) << std::endl;
-    }
-
-    while (order.size() > m_maxChunks)
+    // Never evict the blocks touched by this query.
+    while (
+            order.size() > touched.size() &&
+            selected.bytes > m_maxHierarchyBytes)
     {
         const Hierarchy::Slot* s(order.back());
         order.pop_back();
 
+        selected.bytes -= slots.at(s).bytes;
+        slots.erase(s);
+
         SpinGuard spinLock(s->spinner);
         s->t.reset();
-        slots.erase(s);
     }
 
     assert(order.size() == slots.size());
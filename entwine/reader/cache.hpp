@@ -11,17 +11,24 @@
 #pragma once
 
 #include <atomic>
-#include <condition_variable>
 #include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include <entwine/reader/query-cache.hpp>
 #include <entwine/tree/hierarchy.hpp>
 #include <entwine/types/structure.hpp>
+#include <entwine/util/fair-semaphore.hpp>
+#include <entwine/util/pool.hpp>
 #include <entwine/third/arbiter/arbiter.hpp>
 
 namespace entwine
@@ -29,6 +36,7 @@ namespace entwine
 
 class Cache;
 class ChunkReader;
+class ChunkStats;
 class Reader;
 class Schema;
 
@@ -76,26 +84,99 @@ struct DataChunkState
     std::unique_ptr<InactiveList::iterator> inactiveIt;
     std::atomic_size_t refs;
 
+    // Memory-mapped chunks are backed by the page cache rather than our own
+    // allocations, so only their indexing counts against the Cache's byte
+    // limit.  Like any other chunk, they are kept idle once unreferenced so
+    // that their indexing needn't be rebuilt.  Set on reservation if mapping
+    // will be attempted, and corrected once the chunk is loaded.
+    bool mapped;
+
+    // Bytes charged against the Cache for this chunk.  This is estimated from
+    // the hierarchy point count until the chunk is fetched.
+    std::size_t bytes;
+
+    // Set by the first request for this chunk.  Later requests wait on the
+    // same download rather than starting their own.
+    std::shared_future<const ChunkReader*> fetching;
+
+    // Run once the download in progress completes, successfully or not, by
+    // requests that don't block on it.
+    std::vector<std::function<void()>> fetched;
+
     std::mutex mutex;
 };
 
 
 using SlotOrder = std::list<const Hierarchy::Slot*>;
-using SlotMap = std::map<const Hierarchy::Slot*, SlotOrder::iterator>;
+
+struct CachedSlot
+{
+    SlotOrder::iterator it;
+    std::size_t bytes;
+};
+
+using SlotMap = std::map<const Hierarchy::Slot*, CachedSlot>;
 
 struct HierarchyCache
 {
+    HierarchyCache() : mutex(), slots(), order(), bytes(0) { }
+
     std::mutex mutex;
     SlotMap slots;
     SlotOrder order;
+    std::size_t bytes;
+};
+
+
+
+// Chunk statistics are keyed by (index path, chunk id).
+using StatsKey = std::pair<std::string, Id>;
+using StatsOrder = std::list<StatsKey>;
+
+struct CachedStats
+{
+    std::shared_ptr<const ChunkStats> stats;
+    StatsOrder::iterator it;
+    std::size_t bytes;
+};
+
+struct StatsCache
+{
+    StatsCache() : mutex(), entries(), order(), bytes(0) { }
+
+    std::mutex mutex;
+    std::map<StatsKey, CachedStats> entries;
+    StatsOrder order;
+    std::size_t bytes;
 };
 
 
 
 typedef std::map<Id, std::unique_ptr<DataChunkState>> LocalManager;
 typedef std::map<std::string, LocalManager> GlobalManager;
+
+// Chunk states are spread across shards by (index path, chunk id), each with
+// its own lock and least-recently-used list of idle chunks.
+struct CacheShard
+{
+    CacheShard();
+
+    GlobalManager chunks;
+    InactiveList inactive;
+    std::mutex mutex;
+};
 typedef std::map<Id, const ChunkReader*> ChunkMap;
 
+struct FetchStats
+{
+    FetchStats();
+
+    std::size_t fetches;    // Downloads performed.
+    std::size_t coalesced;  // Requests served by an in-flight download.
+    double totalMs;
+    double maxMs;
+};
+
 class Block
 {
     friend class Cache;
@@ -123,14 +204,83 @@ class Cache
     friend class Block;
 
 public:
-    Cache(std::size_t maxChunks);
+    struct Config
+    {
+        Config()
+            : maxBytes(1024 * 1024 * 1024)
+            , maxHierarchyBytes(256 * 1024 * 1024)
+            , fetchThreads(8)
+            , maxQueryBytes(0)
+            , maxStatsBytes(16 * 1024 * 1024)
+        { }
+
+        // Resident chunks are limited to roughly this much decompressed
+        // point data and indexing.  A query whose chunks alone exceed it is
+        // still served, once nothing else is active.
+        std::size_t maxBytes;
+
+        // Limit on the awakened hierarchy of each index.
+        std::size_t maxHierarchyBytes;
+
+        // Chunk downloads are run by a pool of this many threads, shared by
+        // all queries using this Cache.
+        std::size_t fetchThreads;
+
+        // The complete results of queries are kept in up to this many bytes,
+        // so that repeated queries needn't be run again.  Zero disables this.
+        std::size_t maxQueryBytes;
+
+        // Chunk statistics, and the absence of them, are kept in up to this
+        // many bytes across all indexes.
+        std::size_t maxStatsBytes;
+    };
+
+    // Throws if config.maxBytes can't hold even a small chunk.
+    explicit Cache(const Config& config);
 
     std::unique_ptr<Block> acquire(
             const std::string& readerPath,
             const FetchInfoSet& fetches);
 
+    using Acquired =
+        std::function<void(std::unique_ptr<Block>, std::exception_ptr)>;
+
+    // Acquire without blocking the caller on admission or on the fetches.
+    // Once these complete, done is called on executor with the Block, or
+    // with the error that prevented it.  Continuations are posted to
+    // executor without waiting, and never run on our fetch threads.
+    void acquire(
+            const std::string& readerPath,
+            const FetchInfoSet& fetches,
+            Pool& executor,
+            Acquired done);
+
+    // As above, with our own long-lived executor for the continuations.
+    void acquire(
+            const std::string& readerPath,
+            const FetchInfoSet& fetches,
+            Acquired done)
+    {
+        acquire(readerPath, fetches, m_executor, done);
+    }
+
     void markHierarchy(const std::string& name, const Hierarchy::Slots& slots);
 
+    // The statistics of each of chunkIds within reader, in the same order,
+    // or nullptr for chunks without any.  Those not already cached are
+    // fetched concurrently by our fetch pool.
+    std::vector<std::shared_ptr<const ChunkStats>> stats(
+            const Reader& reader,
+            const std::vector<Id>& chunkIds);
+
+    FetchStats fetchStats() const;
+
+    // Bytes held by blocks that have been acquired and not yet released.
+    std::size_t activeBytes() const { return m_admission.used(); }
+
+    QueryCache& queryCache() { return m_queryCache; }
+    const QueryCache& queryCache() const { return m_queryCache; }
+
 private:
     void release(const Block& block);
 
@@ -138,27 +288,71 @@ private:
             const std::string& readerPath,
             const FetchInfoSet& fetches);
 
+    // Estimated admission cost of these fetches.
+    std::size_t cost(const FetchInfoSet& fetches) const;
+
+    // The remainder of reserve, once cost has been admitted.
+    std::unique_ptr<Block> reserved(
+            const std::string& readerPath,
+            const FetchInfoSet& fetches,
+            std::size_t cost);
+
     bool populate(
             const std::string& readerPath,
             const FetchInfoSet& fetches,
             Block& block);
 
-    const ChunkReader* fetch(
+    using Pending = std::pair<Id, std::shared_future<const ChunkReader*>>;
+
+    // Wait for each pending fetch and set its result in block.
+    bool collect(std::vector<Pending>& pending, Block& block);
+
+    // If fetched is set, it is called once the returned future is ready,
+    // which may be immediately, and our download is posted to the fetch pool
+    // rather than waiting for room in its queue.
+    std::shared_future<const ChunkReader*> fetch(
             const std::string& readerPath,
-            const FetchInfo& fetchInfo);
+            const FetchInfo& fetchInfo,
+            std::function<void()> fetched = nullptr);
+
+    std::unique_ptr<ChunkReader> load(const FetchInfo& fetchInfo, bool mapped);
+
+    CacheShard& shard(const std::string& readerPath, const Id& id);
 
-    std::size_t m_maxChunks;
+    // Drop idle chunks until active and idle bytes fit within m_maxBytes.
+    void evict();
 
-    GlobalManager m_chunkManager;
-    InactiveList m_inactiveList;
+    const std::size_t m_maxBytes;
+    const std::size_t m_maxHierarchyBytes;
+    const std::size_t m_maxStatsBytes;
+
+    std::vector<CacheShard> m_shards;
+
+    // Active chunk bytes are held from this semaphore, so queries are
+    // admitted in arrival order as bytes are released.
+    FairSemaphore m_admission;
+
+    std::atomic_size_t m_inactiveBytes;
+    std::atomic_size_t m_evictCursor;
 
     std::map<std::string, HierarchyCache> m_hierarchyCache;
     std::mutex m_hierarchyMutex;
 
-    std::atomic_size_t m_activeCount;
+    StatsCache m_statsCache;
+
+    FetchStats m_fetchStats;
+    mutable std::mutex m_fetchStatsMutex;
+
+    QueryCache m_queryCache;
+
+    // Runs the continuations of asynchronous acquisitions made without an
+    // executor of their own.  Outlives our fetch pool, whose fetches may post
+    // to it as they complete.
+    Pool m_executor;
 
-    std::mutex m_mutex;
-    std::condition_variable m_cv;
+    // Declared last so that outstanding fetches complete before the rest of
+    // the Cache is destroyed.
+    Pool m_fetchPool;
 };
 
 } // namespace entwine
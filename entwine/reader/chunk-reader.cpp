@@ -10,17 +10,44 @@
 
 #include <entwine/reader/chunk-reader.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
 #include <pdal/PointRef.hpp>
 
+#include <entwine/reader/select-avx2.hpp>
 #include <entwine/tree/chunk.hpp>
 #include <entwine/types/metadata.hpp>
 #include <entwine/types/binary-point-table.hpp>
 #include <entwine/types/schema.hpp>
+#include <entwine/types/structure.hpp>
 #include <entwine/util/compression.hpp>
+#include <entwine/util/mapped-file.hpp>
+#include <entwine/util/unique.hpp>
 
 namespace entwine
 {
 
+namespace
+{
+    bool avx2Supported()
+    {
+#ifdef ENTWINE_AVX2
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    const bool useAvx2(avx2Supported());
+
+    // Coordinates are decoded for selection this many points at a time.
+    const std::size_t selectBlock(4);
+}
+
 ChunkReader::ChunkReader(
         const Metadata& metadata,
         const Id& id,
@@ -30,35 +57,211 @@ ChunkReader::ChunkReader(
     , m_bounds(metadata.boundsScaledCubic())
     , m_id(id)
     , m_depth(depth)
+    , m_pointSize(m_schema.pointSize())
     , m_data()
-    , m_points()
+    , m_mapping()
+    , m_begin(nullptr)
+    , m_numPoints(0)
+    , m_ticks()
+    , m_layout(m_schema)
 {
     Unpacker unpacker(metadata.format().unpack(std::move(data)));
     m_data = unpacker.acquireBytes();
+    m_numPoints = unpacker.numPoints();
 
-    const std::size_t numPoints(unpacker.numPoints());
+    index(m_data->data(), unpacker.ticks());
+}
 
-    BinaryPointTable table(m_schema);
-    pdal::PointRef pointRef(table, 0);
+ChunkReader::ChunkReader(
+        const Metadata& metadata,
+        const Id& id,
+        const std::size_t depth,
+        std::unique_ptr<MappedFile> mapping)
+    : m_schema(metadata.schema())
+    , m_bounds(metadata.boundsScaledCubic())
+    , m_id(id)
+    , m_depth(depth)
+    , m_pointSize(m_schema.pointSize())
+    , m_data()
+    , m_mapping(std::move(mapping))
+    , m_begin(nullptr)
+    , m_numPoints(0)
+    , m_ticks()
+    , m_layout(m_schema)
+{
+    if (metadata.format().compress())
+    {
+        throw std::runtime_error("Cannot map a compressed chunk");
+    }
 
-    const std::size_t pointSize(m_schema.pointSize());
-    const char* pos(m_data->data());
-    Point point;
+    Unpacker unpacker(
+            metadata.format().unpack(m_mapping->data(), m_mapping->size()));
+    m_numPoints = unpacker.numPoints();
 
-    for (std::size_t i(0); i < numPoints; ++i)
+    index(unpacker.rawData(), unpacker.ticks());
+}
+
+ChunkReader::~ChunkReader() { }
+
+void ChunkReader::index(const char* pos, const TickIndex* ticks)
+{
+    if (ticks && (ticks->size() || !m_numPoints))
     {
-        table.setPoint(pos);
+        m_begin = pos;
+        m_ticks = *ticks;
+        return;
+    }
 
-        point.x = pointRef.getFieldAs<double>(pdal::Dimension::Id::X);
-        point.y = pointRef.getFieldAs<double>(pdal::Dimension::Id::Y);
-        point.z = pointRef.getFieldAs<double>(pdal::Dimension::Id::Z);
+    // This chunk was written without a tick index, so sort a copy of its
+    // points by tick.  If we were mapped, the mapping is no longer needed.
+    std::vector<uint64_t> pointTicks(m_numPoints);
+    uint64_t lo(std::numeric_limits<uint64_t>::max());
+    uint64_t hi(0);
 
-        m_points.emplace(
-                std::piecewise_construct,
-                std::forward_as_tuple(Tube::calcTick(point, m_bounds, m_depth)),
-                std::forward_as_tuple(point, pos));
+    for (std::size_t i(0); i < m_numPoints; ++i)
+    {
+        const Point point(m_layout.point(pos + i * m_pointSize));
+        const uint64_t tick(Tube::calcTick(point, m_bounds, m_depth));
 
-        pos += pointSize;
+        pointTicks[i] = tick;
+        lo = std::min(lo, tick);
+        hi = std::max(hi, tick);
+    }
+
+    // Point indices in ascending tick order, stable within a tick.  Ticks
+    // within a chunk are usually dense, so counting-sort them over the span
+    // actually present.  A sparse span falls back to a comparison sort.
+    std::vector<std::size_t> order(m_numPoints);
+    const uint64_t span(hi - lo + 1);
+
+    if (span <= m_numPoints * 4)
+    {
+        std::vector<std::size_t> offsets(span + 1, 0);
+        for (const uint64_t tick : pointTicks) ++offsets[tick - lo + 1];
+
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        for (std::size_t i(0); i < m_numPoints; ++i)
+        {
+            order[offsets[pointTicks[i] - lo]++] = i;
+        }
+    }
+    else
+    {
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(
+                order.begin(),
+                order.end(),
+                [&pointTicks](std::size_t a, std::size_t b)
+                {
+                    return pointTicks[a] < pointTicks[b];
+                });
+    }
+
+    auto sorted(makeUnique<std::vector<char>>(m_numPoints * m_pointSize));
+    char* out(sorted->data());
+
+    for (std::size_t i(0); i < m_numPoints; ++i)
+    {
+        const uint64_t tick(pointTicks[order[i]]);
+        const char* in(pos + order[i] * m_pointSize);
+
+        if (m_ticks.empty() || m_ticks.back().tick != tick)
+        {
+            m_ticks.push_back(TickEntry { tick, i });
+        }
+
+        std::copy(in, in + m_pointSize, out);
+        out += m_pointSize;
+    }
+
+    m_data = std::move(sorted);
+    m_mapping.reset();
+    m_begin = m_data->data();
+}
+
+std::size_t ChunkReader::bytes() const
+{
+    return
+        sizeof(ChunkReader) +
+        (m_data ? m_data->capacity() : 0) +
+        m_ticks.capacity() * sizeof(TickEntry);
+}
+
+std::size_t ChunkReader::estimateBytes(
+        const Schema& schema,
+        const std::size_t numPoints,
+        const bool mapped)
+{
+    // A generous allowance for the tick index.
+    const std::size_t overhead(sizeof(TickEntry));
+    const std::size_t perPoint((mapped ? 0 : schema.pointSize()) + overhead);
+
+    return sizeof(ChunkReader) + numPoints * perPoint;
+}
+
+void ChunkReader::select(
+        const Bounds& queryBounds,
+        const QueryRange& range,
+        std::vector<std::size_t>& selection) const
+{
+    const Point& min(queryBounds.min());
+    const Point& max(queryBounds.max());
+
+    // Coordinates are decoded from the records a block at a time rather than
+    // kept alongside them, so a resident chunk costs no more than its points.
+    double x[selectBlock];
+    double y[selectBlock];
+    double z[selectBlock];
+
+    std::size_t i(range.begin);
+
+    for ( ; i + selectBlock <= range.end; i += selectBlock)
+    {
+        for (std::size_t j(0); j < selectBlock; ++j)
+        {
+            const Point p(m_layout.point(pointData(i + j)));
+            x[j] = p.x;
+            y[j] = p.y;
+            z[j] = p.z;
+        }
+
+        if (useAvx2)
+        {
+            int mask(avx2::within(x, y, z, min, max));
+
+            while (mask)
+            {
+                selection.push_back(i + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+        else
+        {
+            for (std::size_t j(0); j < selectBlock; ++j)
+            {
+                if (
+                        x[j] >= min.x && x[j] < max.x &&
+                        y[j] >= min.y && y[j] < max.y &&
+                        z[j] >= min.z && z[j] < max.z)
+                {
+                    selection.push_back(i + j);
+                }
+            }
+        }
+    }
+
+    for ( ; i < range.end; ++i)
+    {
+        const Point p(m_layout.point(pointData(i)));
+
+        if (
+                p.x >= min.x && p.x < max.x &&
+                p.y >= min.y && p.y < max.y &&
+                p.z >= min.z && p.z < max.z)
+        {
+            selection.push_back(i);
+        }
     }
 }
 
@@ -70,20 +273,47 @@ ChunkReader::QueryRange ChunkReader::candidates(const Bounds& queryBounds) const
     const std::size_t maxTick(
             Tube::calcTick(queryBounds.max(), m_bounds, m_depth));
 
-    It begin(m_points.lower_bound(minTick));
-    It end(m_points.upper_bound(maxTick));
+    const auto begin(
+            std::lower_bound(
+                m_ticks.begin(),
+                m_ticks.end(),
+                minTick,
+                [](const TickEntry& entry, uint64_t tick)
+                {
+                    return entry.tick < tick;
+                }));
 
-    return QueryRange(begin, end);
+    const auto end(
+            std::upper_bound(
+                begin,
+                m_ticks.end(),
+                maxTick,
+                [](uint64_t tick, const TickEntry& entry)
+                {
+                    return tick < entry.tick;
+                }));
+
+    const std::size_t b(begin != m_ticks.end() ? begin->offset : m_numPoints);
+    const std::size_t e(end != m_ticks.end() ? end->offset : m_numPoints);
+
+    return QueryRange(b, e);
 }
 
+constexpr double BaseChunkReader::slop;
+
 BaseChunkReader::BaseChunkReader(
         const Metadata& metadata,
         const Schema& celledSchema,
         const Id& id,
         std::unique_ptr<std::vector<char>> data)
-    : m_id(id)
-    , m_data()
-    , m_tubes(metadata.structure().baseIndexSpan())
+    : m_data()
+    , m_bounds(metadata.boundsScaledCubic())
+    , m_dimensions(metadata.structure().dimensions())
+    , m_depthBegin(metadata.structure().baseDepthBegin())
+    , m_depthEnd(metadata.structure().baseDepthEnd())
+    , m_levels()
+    , m_offsets(metadata.structure().baseIndexSpan() + 1, 0)
+    , m_points()
 {
     Unpacker unpacker(metadata.format().unpack(std::move(data)));
     m_data = unpacker.acquireRawBytes();
@@ -95,31 +325,82 @@ BaseChunkReader::BaseChunkReader(
         m_data = Compression::decompress(*m_data, celledSchema, numPoints);
     }
 
+    for (std::size_t d(m_depthBegin); d < m_depthEnd; ++d)
+    {
+        m_levels.push_back(
+                (ChunkInfo::calcLevelIndex(m_dimensions, d) - id).getSimple());
+    }
+
     BinaryPointTable table(celledSchema);
     pdal::PointRef pointRef(table, 0);
 
     const std::size_t pointSize(celledSchema.pointSize());
-    const char* pos(m_data->data());
-
-    uint64_t tube(0);
-    Point point;
     const auto tubeId(celledSchema.getId("TubeId"));
     const std::size_t dataOffset(sizeof(uint64_t));
 
+    // Count the points of each tube, then place each point in its tube's
+    // range, keeping the stored order within each tube.
+    std::vector<std::size_t> tubes(numPoints);
+    const char* pos(m_data->data());
+
     for (std::size_t i(0); i < numPoints; ++i)
     {
         table.setPoint(pos);
+        tubes[i] = pointRef.getFieldAs<uint64_t>(tubeId);
+        ++m_offsets.at(tubes[i] + 1);
+        pos += pointSize;
+    }
+
+    std::partial_sum(m_offsets.begin(), m_offsets.end(), m_offsets.begin());
 
-        tube = pointRef.getFieldAs<uint64_t>(tubeId);
+    std::vector<std::size_t> order(numPoints);
+    std::vector<std::size_t> cursors(m_offsets.begin(), m_offsets.end() - 1);
+    for (std::size_t i(0); i < numPoints; ++i) order[cursors[tubes[i]]++] = i;
+
+    m_points.reserve(numPoints);
+    Point point;
+
+    for (const std::size_t i : order)
+    {
+        pos = m_data->data() + i * pointSize;
+        table.setPoint(pos);
 
         point.x = pointRef.getFieldAs<double>(pdal::Dimension::Id::X);
         point.y = pointRef.getFieldAs<double>(pdal::Dimension::Id::Y);
         point.z = pointRef.getFieldAs<double>(pdal::Dimension::Id::Z);
 
-        m_tubes.at(tube).emplace_back(point, pos + dataOffset);
+        m_points.emplace_back(point, pos + dataOffset);
+    }
+}
 
-        pos += pointSize;
+std::size_t BaseChunkReader::cell(
+        const double v,
+        const std::size_t axis,
+        const std::size_t side,
+        const double slack) const
+{
+    const double min(axis ? m_bounds.min().y : m_bounds.min().x);
+    const double size(axis ? m_bounds.depth() : m_bounds.width());
+
+    const double c(std::floor((v - min) / size * side + slack));
+    return std::max(0.0, std::min<double>(side - 1, c));
+}
+
+std::size_t BaseChunkReader::interleave(
+        const std::size_t x,
+        const std::size_t y,
+        const std::size_t depth) const
+{
+    // Each climb appends one digit, whose low bit is east and next is north.
+    std::size_t result(0);
+
+    for (std::size_t i(0); i < depth; ++i)
+    {
+        const std::size_t digit(((x >> i) & 1) | ((y >> i) & 1) << 1);
+        result |= digit << (i * m_dimensions);
     }
+
+    return result;
 }
 
 } // namespace entwine
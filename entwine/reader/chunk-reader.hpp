@@ -11,16 +11,17 @@
 #pragma once
 
 #include <cstddef>
-#include <map>
 #include <memory>
 #include <vector>
 
+#include <entwine/types/bounds.hpp>
+#include <entwine/types/format-types.hpp>
 #include <entwine/types/point-pool.hpp>
 
 namespace entwine
 {
 
-class Bounds;
+class MappedFile;
 class Metadata;
 class Schema;
 
@@ -40,7 +41,10 @@ private:
     const char* m_data;
 };
 
-// Ordered by Z-tick to perform the tubular-quadtree-as-octree query.
+// Ordered by Z-tick to perform the tubular-quadtree-as-octree query.  Points
+// are stored contiguously in tick order, so a range of ticks selects a
+// contiguous range of points.  Candidates are tested against query bounds a
+// few at a time, decoding their coordinates as they're selected.
 class ChunkReader
 {
 public:
@@ -50,22 +54,64 @@ public:
             std::size_t depth,
             std::unique_ptr<std::vector<char>> data);
 
-    using PointMap = std::multimap<uint64_t, PointInfo>;
-    using It = PointMap::const_iterator;
+    // Read points directly out of a memory-mapped uncompressed chunk.  No
+    // copy of the point data is made - the mapping is held for the lifetime
+    // of this ChunkReader.
+    ChunkReader(
+            const Metadata& metadata,
+            const Id& id,
+            std::size_t depth,
+            std::unique_ptr<MappedFile> mapping);
+
+    ~ChunkReader();
 
+    // A range of point indices.
     struct QueryRange
     {
-        QueryRange(It begin, It end) : begin(begin), end(end) { }
+        QueryRange(std::size_t begin, std::size_t end)
+            : begin(begin)
+            , end(end)
+        { }
 
-        It begin;
-        It end;
+        std::size_t begin;
+        std::size_t end;
     };
 
     QueryRange candidates(const Bounds& queryBounds) const;
 
+    // Append to selection the indices within range of the points contained
+    // by queryBounds.
+    void select(
+            const Bounds& queryBounds,
+            const QueryRange& range,
+            std::vector<std::size_t>& selection) const;
+
+    const char* pointData(std::size_t i) const
+    {
+        return m_begin + i * m_pointSize;
+    }
+
+    bool mapped() const { return !!m_mapping; }
+    std::size_t pointSize() const { return m_pointSize; }
+    std::size_t numPoints() const { return m_numPoints; }
+
+    // Heap bytes held by this ChunkReader, including its tick index.  Mapped
+    // point data lives in the page cache, so it is not counted.
+    std::size_t bytes() const;
+
+    // Estimate bytes() for a chunk of numPoints points before it is fetched.
+    static std::size_t estimateBytes(
+            const Schema& schema,
+            std::size_t numPoints,
+            bool mapped);
+
 private:
     const Schema& schema() const { return m_schema; }
 
+    // Use the serialized tick index if one exists, otherwise sort our points
+    // by tick ourselves.
+    void index(const char* pos, const TickIndex* ticks);
+
     std::size_t normalize(const Id& rawIndex) const
     {
         return (rawIndex - m_id).getSimple();
@@ -75,12 +121,22 @@ private:
     const Bounds& m_bounds;
     const Id m_id;
     const std::size_t m_depth;
+    const std::size_t m_pointSize;
 
     std::unique_ptr<std::vector<char>> m_data;
-    PointMap m_points;
+    std::unique_ptr<MappedFile> m_mapping;
+
+    const char* m_begin;
+    std::size_t m_numPoints;
+    TickIndex m_ticks;
+
+    const CellLayout m_layout;
 };
 
-// Ordered by normal BaseChunk ordering for traversal.
+// The base is held flat: its points are grouped by tube, in tube order, so
+// the points of each tube are a contiguous range.  The tubes of each depth
+// form a square grid over the X-Y extents of the index, so the tubes that a
+// query overlaps are found directly rather than by walking down the tree.
 class BaseChunkReader
 {
 public:
@@ -90,22 +146,68 @@ public:
             const Id& id,
             std::unique_ptr<std::vector<char>> data);
 
-    using TubeData = std::vector<PointInfo>;
-
-    const TubeData& getTubeData(const Id& id) const
+    // Call f with each point of the tubes at depth whose X-Y extents overlap
+    // queryBounds.  Points are not checked against queryBounds themselves.
+    template<typename F>
+    void query(const Bounds& queryBounds, std::size_t depth, F f) const
     {
-        return m_tubes.at(normalize(id));
+        if (depth < m_depthBegin || depth >= m_depthEnd) return;
+
+        const std::size_t side(1ULL << depth);
+        const std::size_t xBegin(cell(queryBounds.min().x, 0, side, -slop));
+        const std::size_t xEnd(cell(queryBounds.max().x, 0, side, slop) + 1);
+        const std::size_t yBegin(cell(queryBounds.min().y, 1, side, -slop));
+        const std::size_t yEnd(cell(queryBounds.max().y, 1, side, slop) + 1);
+
+        const std::size_t levelBegin(m_levels[depth - m_depthBegin]);
+
+        for (std::size_t y(yBegin); y < yEnd; ++y)
+        {
+            for (std::size_t x(xBegin); x < xEnd; ++x)
+            {
+                const std::size_t tube(levelBegin + interleave(x, y, depth));
+                const std::size_t end(m_offsets[tube + 1]);
+
+                for (std::size_t i(m_offsets[tube]); i < end; ++i)
+                {
+                    f(m_points[i]);
+                }
+            }
+        }
     }
 
 private:
-    std::size_t normalize(const Id& rawIndex) const
-    {
-        return (rawIndex - m_id).getSimple();
-    }
+    // Grid cells are found with a little slack, so that rounding never
+    // excludes a tube whose bounds the query touches.
+    static constexpr double slop = 1e-9;
+
+    // The column or row, along the X or Y axis, of the cell containing v.
+    std::size_t cell(
+            double v,
+            std::size_t axis,
+            std::size_t side,
+            double slack) const;
+
+    // The offset of grid cell (x, y) within its depth, matching the tube
+    // indices that the tree assigns by climbing to it.
+    std::size_t interleave(
+            std::size_t x,
+            std::size_t y,
+            std::size_t depth) const;
 
-    const Id m_id;
     std::unique_ptr<std::vector<char>> m_data;
-    std::vector<TubeData> m_tubes;
+
+    const Bounds m_bounds;
+    const std::size_t m_dimensions;
+    const std::size_t m_depthBegin;
+    const std::size_t m_depthEnd;
+
+    // The first tube of each depth, relative to our ID.
+    std::vector<std::size_t> m_levels;
+
+    // The points of tube t are m_points[m_offsets[t], m_offsets[t + 1]).
+    std::vector<std::size_t> m_offsets;
+    std::vector<PointInfo> m_points;
 };
 
 } // namespace entwine
@@ -15,6 +15,8 @@
 #include <pdal/Dimension.hpp>
 #include <pdal/util/Utils.hpp>
 
+#include <entwine/reader/filter-program.hpp>
+#include <entwine/types/chunk-stats.hpp>
 #include <entwine/types/manifest.hpp>
 #include <entwine/types/metadata.hpp>
 #include <entwine/types/schema.hpp>
@@ -159,6 +161,34 @@ std::unique_ptr<Bounds> maybeExtractBounds(
     return b;
 }
 
+Outcome outcome(const bool never, const bool always)
+{
+    if (never) return Outcome::Never;
+    else if (always) return Outcome::Always;
+    else return Outcome::Maybe;
+}
+
+Outcome equals(const DimStats& stats, const double v)
+{
+    return outcome(
+            !stats.mayContain(v),
+            stats.min() == v && stats.max() == v);
+}
+
+Outcome equalsAny(const DimStats& stats, const std::vector<double>& values)
+{
+    Outcome result(Outcome::Never);
+
+    for (const double v : values)
+    {
+        const Outcome o(equals(stats, v));
+        if (o == Outcome::Always) return o;
+        else if (o == Outcome::Maybe) result = o;
+    }
+
+    return result;
+}
+
 } // unnamed namespace
 
 std::unique_ptr<Comparison> Comparison::create(
@@ -173,12 +203,57 @@ std::unique_ptr<Comparison> Comparison::create(
     const auto id(metadata.schema().getId(dimensionName));
     if (id == pdal::Dimension::Id::Unknown)
     {
+        const auto& constants(metadata.constants());
+        const auto it(constants.find(dimensionName));
+
+        if (it != constants.end())
+        {
+            return makeUnique<ConstantComparison>(
+                    it->second.value(),
+                    dimensionName,
+                    std::move(op));
+        }
+
         throw std::runtime_error("Unknown dimension: " + dimensionName);
     }
 
     return makeUnique<Comparison>(id, dimensionName, std::move(op));
 }
 
+Outcome Comparison::check(const ChunkStats& chunkStats) const
+{
+    const DimStats* stats(chunkStats.find(m_name));
+    if (!stats) return Outcome::Maybe;
+
+    const std::vector<double> values(m_op->values());
+    const double v(values.empty() ? 0 : values.front());
+    const double min(stats->min());
+    const double max(stats->max());
+
+    switch (m_op->type())
+    {
+        case ComparisonType::eq:    return equals(*stats, v);
+        case ComparisonType::ne:    return invert(equals(*stats, v));
+        case ComparisonType::gt:    return outcome(max <= v, min > v);
+        case ComparisonType::gte:   return outcome(max < v, min >= v);
+        case ComparisonType::lt:    return outcome(min >= v, max < v);
+        case ComparisonType::lte:   return outcome(min > v, max <= v);
+        case ComparisonType::in:    return equalsAny(*stats, values);
+        case ComparisonType::nin:   return invert(equalsAny(*stats, values));
+        default:                    return Outcome::Maybe;
+    }
+}
+
+void Comparison::compile(FilterProgram& program) const
+{
+    program.compare(m_dim, m_op->type(), m_op->values());
+}
+
+void ConstantComparison::compile(FilterProgram& program) const
+{
+    program.constant((*m_op)(m_value));
+}
+
 std::unique_ptr<ComparisonOperator> ComparisonOperator::create(
         const Metadata& metadata,
         const std::string& dimensionName,
@@ -118,6 +118,9 @@ public:
         return std::vector<Origin>();
     }
 
+    // The operand, or for multi-valued operators, the operand list.
+    virtual std::vector<double> values() const = 0;
+
     ComparisonType type() const { return m_type; }
 
 protected:
@@ -159,6 +162,11 @@ public:
         return o;
     }
 
+    virtual std::vector<double> values() const override
+    {
+        return std::vector<double>(1, m_val);
+    }
+
 protected:
     Op m_op;
     double m_val;
@@ -189,6 +197,8 @@ public:
         }
     }
 
+    virtual std::vector<double> values() const override { return m_vals; }
+
 protected:
     std::vector<double> m_vals;
     std::vector<Bounds> m_boundsList;
@@ -282,17 +292,58 @@ public:
         return (*m_op)(bounds);
     }
 
+    virtual Outcome check(const ChunkStats& stats) const override;
+
     virtual void log(const std::string& pre) const override
     {
         std::cout << pre << m_name << " ";
         m_op->log("");
     }
 
+    virtual void compile(FilterProgram& program) const override;
+
 protected:
     pdal::Dimension::Id m_dim;
     std::string m_name;
     std::unique_ptr<ComparisonOperator> m_op;
 };
 
+// A comparison against a dimension that was pruned as constant at build time.
+// Its outcome is the same for every point, so it also applies to bounds.
+class ConstantComparison : public Comparison
+{
+public:
+    ConstantComparison(
+            double value,
+            const std::string& dimensionName,
+            std::unique_ptr<ComparisonOperator> op)
+        : Comparison(
+                pdal::Dimension::Id::Unknown,
+                dimensionName,
+                std::move(op))
+        , m_value(value)
+    { }
+
+    bool check(const pdal::PointRef& pointRef) const override
+    {
+        return (*m_op)(m_value);
+    }
+
+    bool check(const Bounds& bounds) const override
+    {
+        return (*m_op)(m_value);
+    }
+
+    virtual Outcome check(const ChunkStats& stats) const override
+    {
+        return (*m_op)(m_value) ? Outcome::Always : Outcome::Never;
+    }
+
+    virtual void compile(FilterProgram& program) const override;
+
+private:
+    const double m_value;
+};
+
 } // namespace entwine
 
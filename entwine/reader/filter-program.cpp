@@ -0,0 +1,271 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#include <entwine/reader/filter-program.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+#include <pdal/PointLayout.hpp>
+
+#include <entwine/reader/chunk-reader.hpp>
+#include <entwine/types/schema.hpp>
+
+namespace entwine
+{
+
+namespace
+{
+    using Instruction = FilterProgram::Instruction;
+
+    template<typename T>
+    double load(const char* pos)
+    {
+        T v;
+        std::memcpy(&v, pos, sizeof(T));
+        return v;
+    }
+
+    // Values are compared as doubles, as the Filterable tree does, so that
+    // thresholds with a fractional part behave the same for integral types.
+    template<typename T, typename Op>
+    struct Compare
+    {
+        static bool test(const Instruction& op, const char* point)
+        {
+            return Op()(load<T>(point + op.offset), op.value);
+        }
+    };
+
+    template<typename T>
+    struct Any
+    {
+        static bool test(const Instruction& op, const char* point)
+        {
+            const double v(load<T>(point + op.offset));
+            for (const double d : op.values) if (v == d) return true;
+            return false;
+        }
+    };
+
+    template<typename T>
+    struct None
+    {
+        static bool test(const Instruction& op, const char* point)
+        {
+            return !Any<T>::test(op, point);
+        }
+    };
+
+    template<typename P>
+    void batch(
+            const Instruction& op,
+            const ChunkReader& chunkReader,
+            std::vector<std::size_t>& selection)
+    {
+        std::size_t out(0);
+
+        for (const std::size_t i : selection)
+        {
+            if (P::test(op, chunkReader.pointData(i))) selection[out++] = i;
+        }
+
+        selection.resize(out);
+    }
+
+    template<typename P>
+    void bind(Instruction& op)
+    {
+        op.test = &P::test;
+        op.batch = &batch<P>;
+    }
+
+    template<typename T>
+    void bind(Instruction& op, ComparisonType type)
+    {
+        switch (type)
+        {
+            case ComparisonType::eq:
+                bind<Compare<T, std::equal_to<double>>>(op);
+                break;
+            case ComparisonType::gt:
+                bind<Compare<T, std::greater<double>>>(op);
+                break;
+            case ComparisonType::gte:
+                bind<Compare<T, std::greater_equal<double>>>(op);
+                break;
+            case ComparisonType::lt:
+                bind<Compare<T, std::less<double>>>(op);
+                break;
+            case ComparisonType::lte:
+                bind<Compare<T, std::less_equal<double>>>(op);
+                break;
+            case ComparisonType::ne:
+                bind<Compare<T, std::not_equal_to<double>>>(op);
+                break;
+            case ComparisonType::in:
+                bind<Any<T>>(op);
+                break;
+            case ComparisonType::nin:
+                bind<None<T>>(op);
+                break;
+            default:
+                throw std::runtime_error("Invalid comparison type enum");
+        }
+    }
+
+    void bind(Instruction& op, pdal::Dimension::Type t, ComparisonType type)
+    {
+        using DimType = pdal::Dimension::Type;
+
+        switch (t)
+        {
+            case DimType::Double:       bind<double>(op, type);     break;
+            case DimType::Float:        bind<float>(op, type);      break;
+            case DimType::Unsigned8:    bind<uint8_t>(op, type);    break;
+            case DimType::Signed8:      bind<int8_t>(op, type);     break;
+            case DimType::Unsigned16:   bind<uint16_t>(op, type);   break;
+            case DimType::Signed16:     bind<int16_t>(op, type);    break;
+            case DimType::Unsigned32:   bind<uint32_t>(op, type);   break;
+            case DimType::Signed32:     bind<int32_t>(op, type);    break;
+            case DimType::Unsigned64:   bind<uint64_t>(op, type);   break;
+            case DimType::Signed64:     bind<int64_t>(op, type);    break;
+            default:
+                throw std::runtime_error("Invalid filter dimension type");
+        }
+    }
+}
+
+FilterProgram::FilterProgram(const Schema& schema)
+    : m_schema(schema)
+    , m_ops()
+{ }
+
+void FilterProgram::compare(
+        const pdal::Dimension::Id id,
+        const ComparisonType type,
+        const std::vector<double>& values)
+{
+    const pdal::Dimension::Detail* detail(
+            m_schema.pdalLayout().dimDetail(id));
+
+    Instruction op(Code::Test);
+    op.offset = detail->offset();
+
+    if (isSingle(type)) op.value = values.at(0);
+    else op.values = values;
+
+    bind(op, detail->type(), type);
+    m_ops.push_back(op);
+}
+
+void FilterProgram::constant(const bool value)
+{
+    Instruction op(Code::Constant);
+    op.value = value ? 1 : 0;
+    m_ops.push_back(op);
+}
+
+void FilterProgram::gate(
+        const std::vector<std::unique_ptr<Filterable>>& filters,
+        const bool exit,
+        const bool empty)
+{
+    if (filters.empty())
+    {
+        constant(empty);
+        return;
+    }
+
+    std::vector<std::size_t> jumps;
+
+    for (std::size_t i(0); i < filters.size(); ++i)
+    {
+        filters[i]->compile(*this);
+
+        if (i + 1 < filters.size())
+        {
+            jumps.push_back(m_ops.size());
+            m_ops.emplace_back(exit ? Code::JumpIfTrue : Code::JumpIfFalse);
+        }
+    }
+
+    for (const std::size_t j : jumps) m_ops[j].target = m_ops.size();
+}
+
+void FilterProgram::negate()
+{
+    m_ops.emplace_back(Code::Negate);
+}
+
+bool FilterProgram::check(const char* point) const
+{
+    bool result(true);
+    std::size_t pc(0);
+
+    while (pc < m_ops.size())
+    {
+        const Instruction& op(m_ops[pc++]);
+
+        switch (op.code)
+        {
+            case Code::Test:        result = op.test(op, point);    break;
+            case Code::Constant:    result = op.value != 0;         break;
+            case Code::JumpIfFalse: if (!result) pc = op.target;    break;
+            case Code::JumpIfTrue:  if (result) pc = op.target;     break;
+            case Code::Negate:      result = !result;               break;
+        }
+    }
+
+    return result;
+}
+
+void FilterProgram::select(
+        const ChunkReader& chunkReader,
+        std::vector<std::size_t>& selection) const
+{
+    if (conjunctive())
+    {
+        for (const Instruction& op : m_ops)
+        {
+            if (op.code == Code::Test) op.batch(op, chunkReader, selection);
+            else if (op.code == Code::Constant && !op.value) selection.clear();
+
+            if (selection.empty()) return;
+        }
+    }
+    else
+    {
+        std::size_t out(0);
+
+        for (const std::size_t i : selection)
+        {
+            if (check(chunkReader.pointData(i))) selection[out++] = i;
+        }
+
+        selection.resize(out);
+    }
+}
+
+bool FilterProgram::conjunctive() const
+{
+    return std::all_of(m_ops.begin(), m_ops.end(), [](const Instruction& op)
+    {
+        return
+            op.code == Code::Test ||
+            op.code == Code::Constant ||
+            op.code == Code::JumpIfFalse;
+    });
+}
+
+} // namespace entwine
+
@@ -0,0 +1,115 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <pdal/Dimension.hpp>
+
+#include <entwine/reader/comparison.hpp>
+
+namespace entwine
+{
+
+class ChunkReader;
+class Schema;
+
+// A Filterable tree flattened for evaluation against raw point data.  The tree
+// is compiled once per query into a linear list of instructions: comparisons
+// load their dimension from a fixed offset within the point with a test
+// specialized for its storage type, and logical gates become short-circuit
+// jumps past their remaining children.  The tree itself remains the reference
+// implementation.
+class FilterProgram
+{
+public:
+    explicit FilterProgram(const Schema& schema);
+
+    enum class Code
+    {
+        Test,
+        Constant,
+        JumpIfFalse,
+        JumpIfTrue,
+        Negate
+    };
+
+    struct Instruction;
+
+    using Test = bool (*)(const Instruction& op, const char* point);
+    using Batch = void (*)(
+            const Instruction& op,
+            const ChunkReader& chunkReader,
+            std::vector<std::size_t>& selection);
+
+    struct Instruction
+    {
+        explicit Instruction(Code code)
+            : code(code)
+            , test(nullptr)
+            , batch(nullptr)
+            , offset(0)
+            , value(0)
+            , values()
+            , target(0)
+        { }
+
+        Code code;
+
+        Test test;
+        Batch batch;
+        std::size_t offset;
+        double value;
+        std::vector<double> values;
+
+        std::size_t target;
+    };
+
+    // Emitted by Filterable::compile.
+    void compare(
+            pdal::Dimension::Id id,
+            ComparisonType type,
+            const std::vector<double>& values);
+
+    void constant(bool value);
+
+    // Compile filters as the children of a logical gate.  Evaluation stops at
+    // the first child whose result is exit, and an empty gate yields empty.
+    void gate(
+            const std::vector<std::unique_ptr<Filterable>>& filters,
+            bool exit,
+            bool empty);
+
+    void negate();
+
+    bool check(const char* point) const;
+
+    // Remove from selection the indices of the points within chunkReader that
+    // do not pass.
+    void select(
+            const ChunkReader& chunkReader,
+            std::vector<std::size_t>& selection) const;
+
+    const std::vector<Instruction>& instructions() const { return m_ops; }
+
+private:
+    // True if the program is a conjunction of tests, in which case each test
+    // may be applied to a whole selection before the next.
+    bool conjunctive() const;
+
+    const Schema& m_schema;
+    std::vector<Instruction> m_ops;
+};
+
+} // namespace entwine
+
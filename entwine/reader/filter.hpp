@@ -15,6 +15,7 @@
 #include <json/json.h>
 
 #include <entwine/reader/comparison.hpp>
+#include <entwine/reader/filter-program.hpp>
 #include <entwine/reader/logic-gate.hpp>
 #include <entwine/types/delta.hpp>
 #include <entwine/types/metadata.hpp>
@@ -33,21 +34,46 @@ public:
         : m_metadata(metadata)
         , m_queryBounds(queryBounds)
         , m_root()
+        , m_program(metadata.schema())
     {
         if (json.isObject()) build(m_root, json, delta);
         m_root.log("");
+        m_root.compile(m_program);
     }
 
+    // Evaluates the Filterable tree directly.  This is the reference for the
+    // compiled program, which is used for the points of a query.
     bool check(const pdal::PointRef& pointRef) const
     {
         return m_root.check(pointRef);
     }
 
+    bool check(const char* point) const
+    {
+        return m_program.check(point);
+    }
+
+    // Remove from selection the points of chunkReader that do not pass.
+    void select(
+            const ChunkReader& chunkReader,
+            std::vector<std::size_t>& selection) const
+    {
+        m_program.select(chunkReader, selection);
+    }
+
     bool check(const Bounds& bounds) const
     {
         return m_queryBounds.overlaps(bounds) && m_root.check(bounds);
     }
 
+    // False if no point summarized by stats can pass.
+    bool check(const ChunkStats& stats) const
+    {
+        return m_root.check(stats) != Outcome::Never;
+    }
+
+    bool empty() const { return m_root.empty(); }
+
 private:
     void build(LogicGate& gate, const Json::Value& json, const Delta* delta)
     {
@@ -120,6 +146,7 @@ private:
     const Metadata& m_metadata;
     const Bounds m_queryBounds;
     LogicalAnd m_root;
+    FilterProgram m_program;
 };
 
 } // namespace entwine
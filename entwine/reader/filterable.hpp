@@ -20,12 +20,37 @@
 namespace entwine
 {
 
+class ChunkStats;
+class FilterProgram;
+
+// The outcome of a filter over every point summarized by a ChunkStats.
+enum class Outcome
+{
+    Never,
+    Maybe,
+    Always
+};
+
+inline Outcome invert(Outcome o)
+{
+    if (o == Outcome::Never) return Outcome::Always;
+    else if (o == Outcome::Always) return Outcome::Never;
+    else return Outcome::Maybe;
+}
+
 class Filterable
 {
 public:
     virtual bool check(const pdal::PointRef& pointRef) const = 0;
     virtual bool check(const Bounds& bounds) const { return true; }
+    virtual Outcome check(const ChunkStats& stats) const
+    {
+        return Outcome::Maybe;
+    }
     virtual void log(const std::string& pre) const = 0;
+
+    // Append the instructions that evaluate this filter to program.
+    virtual void compile(FilterProgram& program) const = 0;
 };
 
 } // namespace entwine
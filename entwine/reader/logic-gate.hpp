@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <entwine/reader/filter-program.hpp>
 #include <entwine/reader/filterable.hpp>
 
 namespace entwine
@@ -52,6 +53,8 @@ public:
         m_filters.push_back(std::move(f));
     }
 
+    bool empty() const { return m_filters.empty(); }
+
 protected:
     std::vector<std::unique_ptr<Filterable>> m_filters;
 };
@@ -79,11 +82,30 @@ public:
         return true;
     }
 
+    virtual Outcome check(const ChunkStats& stats) const override
+    {
+        Outcome result(Outcome::Always);
+
+        for (const auto& f : m_filters)
+        {
+            const Outcome o(f->check(stats));
+            if (o == Outcome::Never) return o;
+            else if (o == Outcome::Maybe) result = o;
+        }
+
+        return result;
+    }
+
     virtual void log(const std::string& pre) const override
     {
         if (m_filters.size()) std::cout << pre << "AND" << std::endl;
         for (const auto& c : m_filters) c->log(pre + "  ");
     }
+
+    virtual void compile(FilterProgram& program) const override
+    {
+        program.gate(m_filters, false, true);
+    }
 };
 
 class LogicalOr : public LogicGate
@@ -109,11 +131,30 @@ public:
         return false;
     }
 
+    virtual Outcome check(const ChunkStats& stats) const override
+    {
+        Outcome result(Outcome::Never);
+
+        for (const auto& f : m_filters)
+        {
+            const Outcome o(f->check(stats));
+            if (o == Outcome::Always) return o;
+            else if (o == Outcome::Maybe) result = o;
+        }
+
+        return result;
+    }
+
     virtual void log(const std::string& pre) const override
     {
         std::cout << pre << "OR" << std::endl;
         for (const auto& c : m_filters) c->log(pre + "  ");
     }
+
+    virtual void compile(FilterProgram& program) const override
+    {
+        program.gate(m_filters, true, false);
+    }
 };
 
 class LogicalNor : public LogicalOr
@@ -130,11 +171,22 @@ public:
         return !LogicalOr::check(bounds);
     }
 
+    virtual Outcome check(const ChunkStats& stats) const override
+    {
+        return invert(LogicalOr::check(stats));
+    }
+
     virtual void log(const std::string& pre) const override
     {
         std::cout << pre << "NOR" << std::endl;
         for (const auto& c : m_filters) c->log(pre + "  ");
     }
+
+    virtual void compile(FilterProgram& program) const override
+    {
+        LogicalOr::compile(program);
+        program.negate();
+    }
 };
 
 } // namespace entwine
@@ -0,0 +1,117 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#include <entwine/reader/query-cache.hpp>
+
+#include <iterator>
+#include <utility>
+
+namespace entwine
+{
+
+QueryCacheStats::QueryCacheStats()
+    : hits(0)
+    , misses(0)
+    , entries(0)
+    , bytes(0)
+{ }
+
+QueryCache::QueryCache(const std::size_t maxBytes)
+    : m_maxBytes(maxBytes)
+    , m_order()
+    , m_entries()
+    , m_stats()
+    , m_mutex()
+{ }
+
+QueryCache::Data QueryCache::get(
+        const std::string& readerPath,
+        const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto readerIt(m_entries.find(readerPath));
+    if (readerIt != m_entries.end())
+    {
+        const auto it(readerIt->second.find(key));
+        if (it != readerIt->second.end())
+        {
+            m_order.splice(m_order.begin(), m_order, it->second);
+            ++m_stats.hits;
+            return it->second->data;
+        }
+    }
+
+    ++m_stats.misses;
+    return Data();
+}
+
+void QueryCache::put(
+        const std::string& readerPath,
+        const std::string& key,
+        std::vector<char> data)
+{
+    if (data.size() > m_maxBytes) return;
+
+    const Data shared(std::make_shared<const std::vector<char>>(
+                std::move(data)));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Concurrent misses for the same query may each store their results -
+    // the latest replaces the others.
+    const auto readerIt(m_entries.find(readerPath));
+    if (readerIt != m_entries.end())
+    {
+        const auto it(readerIt->second.find(key));
+        if (it != readerIt->second.end()) erase(it->second);
+    }
+
+    m_order.emplace_front(readerPath, key, shared);
+    m_entries[readerPath][key] = m_order.begin();
+
+    ++m_stats.entries;
+    m_stats.bytes += shared->size();
+
+    while (m_stats.bytes > m_maxBytes) erase(std::prev(m_order.end()));
+}
+
+void QueryCache::invalidate(const std::string& readerPath)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto readerIt(m_entries.find(readerPath));
+    if (readerIt == m_entries.end()) return;
+
+    std::vector<Order::iterator> doomed;
+    for (const auto& p : readerIt->second) doomed.push_back(p.second);
+    for (const auto it : doomed) erase(it);
+}
+
+QueryCacheStats QueryCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void QueryCache::erase(const Order::iterator it)
+{
+    --m_stats.entries;
+    m_stats.bytes -= it->data->size();
+
+    const auto readerIt(m_entries.find(it->readerPath));
+    readerIt->second.erase(it->key);
+    if (readerIt->second.empty()) m_entries.erase(readerIt);
+
+    m_order.erase(it);
+}
+
+} // namespace entwine
+
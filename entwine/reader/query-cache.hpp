@@ -0,0 +1,96 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace entwine
+{
+
+struct QueryCacheStats
+{
+    QueryCacheStats();
+
+    double hitRatio() const
+    {
+        return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0;
+    }
+
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t entries;
+    std::size_t bytes;
+};
+
+// The complete output of recent queries, keyed by index path and a normalized
+// description of the query.  Results are held to a byte budget, evicting the
+// least recently used first.  A budget of zero disables caching.
+class QueryCache
+{
+public:
+    using Data = std::shared_ptr<const std::vector<char>>;
+
+    explicit QueryCache(std::size_t maxBytes);
+
+    bool enabled() const { return m_maxBytes; }
+    std::size_t maxBytes() const { return m_maxBytes; }
+
+    // Returns nullptr if these results aren't cached.
+    Data get(const std::string& readerPath, const std::string& key);
+
+    // Results larger than our entire budget are not stored.
+    void put(
+            const std::string& readerPath,
+            const std::string& key,
+            std::vector<char> data);
+
+    // Drop every cached result for this index.
+    void invalidate(const std::string& readerPath);
+
+    QueryCacheStats stats() const;
+
+private:
+    struct Entry
+    {
+        Entry(const std::string& readerPath, const std::string& key, Data data)
+            : readerPath(readerPath)
+            , key(key)
+            , data(data)
+        { }
+
+        std::string readerPath;
+        std::string key;
+        Data data;
+    };
+
+    using Order = std::list<Entry>;
+    using Entries = std::unordered_map<std::string, Order::iterator>;
+
+    void erase(Order::iterator it);
+
+    const std::size_t m_maxBytes;
+
+    Order m_order;
+    std::map<std::string, Entries> m_entries;
+
+    QueryCacheStats m_stats;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace entwine
+
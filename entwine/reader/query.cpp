@@ -17,13 +17,17 @@
 
 #include <entwine/reader/cache.hpp>
 #include <entwine/reader/chunk-reader.hpp>
+#include <entwine/reader/query-cache.hpp>
 #include <entwine/reader/reader.hpp>
 #include <entwine/tree/chunk.hpp>
 #include <entwine/tree/climber.hpp>
+#include <entwine/types/chunk-stats.hpp>
 #include <entwine/types/dir.hpp>
 #include <entwine/types/metadata.hpp>
 #include <entwine/types/schema.hpp>
 #include <entwine/types/tube.hpp>
+#include <entwine/util/json.hpp>
+#include <entwine/util/pool.hpp>
 #include <entwine/util/unique.hpp>
 
 namespace entwine
@@ -75,59 +79,227 @@ Query::Query(
     , m_depthEnd(depthEnd)
     , m_chunks()
     , m_block()
+    , m_prefetches()
+    , m_prefetchWindow(1)
     , m_chunkReaderIt()
+    , m_selection()
+    , m_selectionPos(0)
+    , m_pagePoints(0)
+    , m_pool(nullptr)
+    , m_pointLimit(0)
     , m_numPoints(0)
+    , m_plannedPoints(0)
     , m_base(true)
     , m_done(false)
     , m_outSchema(schema)
     , m_table(m_reader.metadata().schema())
     , m_pointRef(m_table, 0)
     , m_filter(m_reader.metadata(), m_queryBounds, filter, m_delta.get())
+    , m_constants()
+    , m_cacheKey()
+    , m_cached()
+    , m_record()
+    , m_recording(false)
 {
+    // Dimensions pruned as constant at build time aren't in our stored
+    // schema - if they're requested, synthesize them from the metadata.
+    const Metadata& metadata(m_reader.metadata());
+    for (const auto& dim : m_outSchema.dims())
+    {
+        const auto it(metadata.constants().find(dim.name()));
+        const bool synthesize(
+                it != metadata.constants().end() &&
+                !metadata.schema().contains(dim.name()));
+
+        m_constants.push_back(synthesize ? &it->second : nullptr);
+    }
+
+    QueryCache& queryCache(m_cache.queryCache());
+
+    if (queryCache.enabled())
+    {
+        m_cacheKey = cacheKey(filter);
+        m_cached = queryCache.get(m_reader.path(), m_cacheKey);
+        m_recording = !m_cached;
+    }
+
+    if (m_cached) return;
+
     if (!m_depthEnd || m_depthEnd > m_structure.coldDepthBegin())
     {
         QueryChunkState chunkState(
                 m_structure,
                 m_reader.metadata().boundsScaledCubic());
-        getFetches(chunkState);
+        Candidates candidates;
+        getFetches(chunkState, nullptr, candidates);
+        select(candidates);
         // std::cout << "Fetches: " << m_chunks.size() << std::endl;
     }
 }
 
-void Query::getFetches(const QueryChunkState& chunkState)
+Query::~Query()
 {
-    if (!m_filter.check(chunkState.bounds())) return;
+    release();
+}
 
-    if (
-            chunkState.depth() >= m_depthBegin &&
-            chunkState.depth() >= m_structure.coldDepthBegin() &&
-            m_reader.exists(chunkState.chunkId()))
+void Query::release()
+{
+    m_block.reset();
+
+    while (m_prefetches.size())
     {
-        m_chunks.emplace(
-                m_reader,
-                chunkState.chunkId(),
-                chunkState.pointsPerChunk(),
-                chunkState.depth());
+        std::future<std::unique_ptr<Block>> next(
+                std::move(m_prefetches.front()));
+        m_prefetches.pop_front();
+
+        try
+        {
+            next.get();
+        }
+        catch (...)
+        {
+            // The results of a failed prefetch don't matter to us anymore.
+        }
     }
-    else if (
-            chunkState.depth() >= m_structure.coldDepthBegin() &&
-            !m_reader.exists(chunkState.chunkId()))
+}
+
+void Query::getFetches(
+        const QueryChunkState& chunkState,
+        const Hierarchy::Nodes* parents,
+        Candidates& candidates) const
+{
+    if (!m_filter.check(chunkState.bounds())) return;
+
+    const bool cold(chunkState.depth() >= m_structure.coldDepthBegin());
+    if (cold && !m_reader.exists(chunkState.chunkId())) return;
+
+    // Our nodes are found among those of our parent chunk, so the hierarchy
+    // is walked once for the whole query rather than once per chunk.
+    Hierarchy::Nodes nodes;
+    const uint64_t n(
+            m_reader.count(
+                m_queryBounds.intersection(chunkState.bounds()),
+                chunkState.depth(),
+                parents,
+                nodes));
+
+    // If no points overlap our query at this depth, none will deeper.
+    if (!n) return;
+
+    const bool counted(n != Hierarchy::uncounted);
+
+    if (cold && chunkState.depth() >= m_depthBegin)
     {
-        return;
+        candidates.emplace_back(
+                FetchInfo(
+                    m_reader,
+                    chunkState.chunkId(),
+                    chunkState.pointsPerChunk(),
+                    chunkState.depth()),
+                counted ? n : 0);
     }
 
     if (chunkState.depth() + 1 < m_depthEnd)
     {
+        const Hierarchy::Nodes* next(counted ? &nodes : nullptr);
+
         if (chunkState.allDirections())
         {
             for (std::size_t i(0); i < 4; ++i)
             {
-                getFetches(chunkState.getClimb(toDir(i)));
+                getFetches(chunkState.getClimb(toDir(i)), next, candidates);
             }
         }
         else
         {
-            getFetches(chunkState.getClimb());
+            getFetches(chunkState.getClimb(), next, candidates);
+        }
+    }
+}
+
+void Query::select(const Candidates& candidates)
+{
+    // A chunk's statistics don't say anything about its descendants, so
+    // getFetches has climbed past every candidate regardless.
+    std::vector<std::shared_ptr<const ChunkStats>> stats;
+
+    if (!m_filter.empty())
+    {
+        std::vector<Id> ids;
+        ids.reserve(candidates.size());
+        for (const auto& c : candidates) ids.push_back(c.first.id);
+
+        stats = m_reader.stats(ids);
+    }
+
+    for (std::size_t i(0); i < candidates.size(); ++i)
+    {
+        if (stats.empty() || !stats[i] || m_filter.check(*stats[i]))
+        {
+            m_chunks.insert(candidates[i].first);
+            m_plannedPoints += candidates[i].second;
+        }
+    }
+}
+
+std::string Query::cacheKey(const Json::Value& filter) const
+{
+    Json::Value json;
+    json["bounds"] = m_queryBounds.toJson();
+    json["depthBegin"] = static_cast<Json::UInt64>(m_depthBegin);
+    json["depthEnd"] = static_cast<Json::UInt64>(m_depthEnd);
+    json["schema"] = m_outSchema.toJson();
+
+    // Object members are ordered by name, so equal filters serialize equally.
+    if (!filter.empty()) json["filter"] = filter;
+
+    if (m_delta)
+    {
+        json["scale"] = m_delta->scale().toJson();
+        json["offset"] = m_delta->offset().toJson();
+    }
+
+    return toFastString(json);
+}
+
+void Query::record(const std::vector<char>& buffer, const std::size_t initial)
+{
+    QueryCache& queryCache(m_cache.queryCache());
+
+    if (m_record.size() + buffer.size() - initial > queryCache.maxBytes())
+    {
+        // Too large to be cached, so stop copying.
+        m_recording = false;
+        std::vector<char>().swap(m_record);
+        return;
+    }
+
+    m_record.insert(m_record.end(), buffer.begin() + initial, buffer.end());
+
+    if (m_done)
+    {
+        queryCache.put(m_reader.path(), m_cacheKey, std::move(m_record));
+        m_recording = false;
+    }
+}
+
+void Query::run(
+        const std::function<void(const std::vector<char>&)>& sink,
+        const std::size_t pagePoints)
+{
+    m_pagePoints = pagePoints;
+
+    std::vector<char> buffer;
+    buffer.reserve(pagePoints * m_outSchema.pointSize());
+
+    while (!done())
+    {
+        next(buffer);
+
+        if (buffer.size())
+        {
+            sink(buffer);
+            buffer.clear();
         }
     }
 }
@@ -136,16 +308,24 @@ bool Query::next(std::vector<char>& buffer)
 {
     if (m_done) throw std::runtime_error("Called next after query completed");
 
+    if (m_cached)
+    {
+        buffer.insert(buffer.end(), m_cached->begin(), m_cached->end());
+        m_numPoints = m_cached->size() / m_outSchema.pointSize();
+        m_done = true;
+        limit(buffer);
+        return false;
+    }
+
+    const std::size_t initial(buffer.size());
+
     if (m_base)
     {
         m_base = false;
 
-        if (m_reader.base())
+        if (m_depthBegin < m_structure.baseDepthEnd() && m_reader.base())
         {
-            PointState pointState(
-                    m_structure,
-                    m_reader.metadata().boundsScaledCubic());
-            getBase(buffer, pointState);
+            getBase(buffer);
         }
 
         if (buffer.empty())
@@ -159,35 +339,166 @@ bool Query::next(std::vector<char>& buffer)
         getChunked(buffer);
     }
 
+    limit(buffer);
+    if (m_recording) record(buffer, initial);
+
     return !m_done;
 }
 
-void Query::getBase(std::vector<char>& buffer, const PointState& pointState)
+struct Query::AsyncRun
+{
+    AsyncRun(std::shared_ptr<Query> query, Pool& executor, Done done)
+        : query(query)
+        , executor(executor)
+        , done(done)
+        , buffer()
+    { }
+
+    std::shared_ptr<Query> query;
+    Pool& executor;
+    Done done;
+    std::vector<char> buffer;
+};
+
+void Query::runAsync(
+        const std::shared_ptr<Query> query,
+        Pool& executor,
+        const Done done)
 {
-    if (!m_queryBounds.overlaps(pointState.bounds(), true)) return;
+    auto run(std::make_shared<AsyncRun>(query, executor, done));
+    Query& q(*query);
 
-    if (pointState.depth() >= m_structure.baseDepthBegin())
+    try
     {
-        const auto& cell(m_reader.base()->getTubeData(pointState.index()));
-        if (cell.empty()) return;
+        if (q.m_done || !q.m_base)
+        {
+            throw std::runtime_error("Called runAsync after next");
+        }
 
-        if (pointState.depth() >= m_depthBegin)
+        if (q.m_cached)
         {
-            for (const PointInfo& pointInfo : cell)
+            q.next(run->buffer);
+        }
+        else
+        {
+            q.m_base = false;
+
+            if (
+                    q.m_depthBegin < q.m_structure.baseDepthEnd() &&
+                    q.m_reader.base())
             {
-                if (processPoint(buffer, pointInfo)) ++m_numPoints;
+                q.getBase(run->buffer);
             }
+
+            q.m_done = q.m_chunks.empty();
+            q.limit(run->buffer);
+            if (q.m_recording) q.record(run->buffer, 0);
         }
     }
+    catch (...)
+    {
+        done(std::vector<char>(), std::current_exception());
+        return;
+    }
 
-    if (
-            pointState.depth() + 1 < m_structure.baseDepthEnd() &&
-            pointState.depth() + 1 < m_depthEnd)
+    acquireNext(run);
+}
+
+void Query::acquireNext(const std::shared_ptr<AsyncRun> run)
+{
+    Query& q(*run->query);
+
+    if (q.m_done)
+    {
+        run->done(std::move(run->buffer), std::exception_ptr());
+        return;
+    }
+
+    const auto process([run](std::exception_ptr error)
     {
-        for (std::size_t i(0); i < dirHalfEnd(); ++i)
+        Query& q(*run->query);
+        std::vector<char>& buffer(run->buffer);
+
+        try
         {
-            getBase(buffer, pointState.getClimb(toDir(i)));
+            if (error) std::rethrow_exception(error);
+
+            const std::size_t initial(buffer.size());
+            const std::size_t pointSize(q.m_outSchema.pointSize());
+            std::vector<char> output;
+
+            for (const auto& c : q.m_block->chunkMap())
+            {
+                const ChunkReader* cr(c.second);
+                if (!cr) throw std::runtime_error("Reservation failure");
+
+                output.clear();
+                q.scan(*cr, output);
+                buffer.insert(buffer.end(), output.begin(), output.end());
+                q.m_numPoints += output.size() / pointSize;
+            }
+
+            q.m_block.reset();
+            q.m_done = q.m_chunks.empty();
+            q.limit(buffer);
+            if (q.m_recording) q.record(buffer, initial);
         }
+        catch (...)
+        {
+            q.m_block.reset();
+            run->done(std::vector<char>(), std::current_exception());
+            return;
+        }
+
+        acquireNext(run);
+    });
+
+    q.m_cache.acquire(
+            q.m_reader.path(),
+            q.nextFetches(),
+            run->executor,
+            [run, process](std::unique_ptr<Block> block, std::exception_ptr e)
+            {
+                run->query->m_block = std::move(block);
+                process(e);
+            });
+}
+
+void Query::limit(std::vector<char>& buffer)
+{
+    if (!m_pointLimit || m_numPoints < m_pointLimit) return;
+
+    const std::size_t excess(m_numPoints - m_pointLimit);
+
+    if (excess || !m_done)
+    {
+        // What remains is only a prefix of our full results, so it mustn't
+        // be cached.  Results fetched from the cache are truncated likewise.
+        buffer.resize(buffer.size() - excess * m_outSchema.pointSize());
+        m_numPoints = m_pointLimit;
+        m_recording = false;
+        m_done = true;
+
+        // Give up our budget, and the chunks we'll never emit.
+        m_chunks.clear();
+        release();
+    }
+}
+
+void Query::getBase(std::vector<char>& buffer)
+{
+    const BaseChunkReader& base(*m_reader.base());
+
+    const std::size_t begin(
+            std::max(m_depthBegin, m_structure.baseDepthBegin()));
+    const std::size_t end(std::min(m_depthEnd, m_structure.baseDepthEnd()));
+
+    for (std::size_t depth(begin); depth < end; ++depth)
+    {
+        base.query(m_queryBounds, depth, [this, &buffer](const PointInfo& p)
+        {
+            if (processPoint(buffer, p)) ++m_numPoints;
+        });
     }
 }
 
@@ -195,34 +506,72 @@ void Query::getChunked(std::vector<char>& buffer)
 {
     if (!m_block)
     {
-        if (m_chunks.size())
+        if (m_prefetches.size())
         {
-            const auto begin(m_chunks.begin());
-            auto end(m_chunks.begin());
-            std::advance(end, std::min(fetchesPerIteration, m_chunks.size()));
+            std::future<std::unique_ptr<Block>> next(
+                    std::move(m_prefetches.front()));
+            m_prefetches.pop_front();
 
-            FetchInfoSet subset(begin, end);
-            m_block = m_cache.acquire(m_reader.path(), subset);
-            m_chunks.erase(begin, end);
-
-            if (m_block) m_chunkReaderIt = m_block->chunkMap().begin();
+            m_block = next.get();
         }
+        else if (m_chunks.size())
+        {
+            m_block = m_cache.acquire(m_reader.path(), nextFetches());
+        }
+
+        if (m_block) m_chunkReaderIt = m_block->chunkMap().begin();
+
+        prefetch();
     }
 
-    if (m_block)
+    if (m_block && m_pool)
+    {
+        processBlock(buffer);
+        m_block.reset();
+    }
+    else if (m_block)
     {
         if (const ChunkReader* cr = m_chunkReaderIt->second)
         {
-            ChunkReader::QueryRange range(cr->candidates(m_queryBounds));
-            auto it(range.begin);
+            // If the previous chunk is finished, select from this one.
+            if (m_selectionPos == m_selection.size())
+            {
+                const ChunkReader::QueryRange range(
+                        cr->candidates(m_queryBounds));
+
+                m_selection.clear();
+                m_selectionPos = 0;
+                cr->select(m_queryBounds, range, m_selection);
+                m_filter.select(*cr, m_selection);
+            }
+
+            std::size_t end(m_selection.size());
 
-            while (it != range.end)
+            if (m_pagePoints)
             {
-                if (processPoint(buffer, it->second)) ++m_numPoints;
-                ++it;
+                end = std::min(end, m_selectionPos + m_pagePoints);
             }
 
-            if (++m_chunkReaderIt == m_block->chunkMap().end())
+            // Our selection has already been filtered, so every selected
+            // point is written.
+            const std::size_t pointSize(m_outSchema.pointSize());
+            const std::size_t initial(buffer.size());
+            buffer.resize(initial + (end - m_selectionPos) * pointSize);
+            char* pos(buffer.data() + initial);
+
+            for ( ; m_selectionPos < end; ++m_selectionPos)
+            {
+                processSelected(
+                        pos,
+                        cr->pointData(m_selection[m_selectionPos]));
+
+                pos += pointSize;
+                ++m_numPoints;
+            }
+
+            if (
+                    m_selectionPos == m_selection.size() &&
+                    ++m_chunkReaderIt == m_block->chunkMap().end())
             {
                 m_block.reset();
             }
@@ -233,89 +582,167 @@ void Query::getChunked(std::vector<char>& buffer)
         }
     }
 
-    m_done = !m_block && m_chunks.empty();
+    m_done = !m_block && m_chunks.empty() && m_prefetches.empty();
 }
 
-bool Query::processPoint(std::vector<char>& buffer, const PointInfo& info)
+void Query::processBlock(std::vector<char>& buffer)
 {
-    if (m_queryBounds.contains(info.point()))
-    {
-        m_table.setPoint(info.data());
+    const ChunkMap& chunks(m_block->chunkMap());
 
-        if (!m_filter.check(m_pointRef)) return false;
+    std::vector<std::vector<char>> outputs(chunks.size());
+    std::vector<std::future<void>> scans;
 
-        buffer.resize(buffer.size() + m_outSchema.pointSize(), 0);
-        char* pos(buffer.data() + buffer.size() - m_outSchema.pointSize());
+    // If we're running on our scan pool, its workers may all be blocked here
+    // waiting on scans queued behind them, so scan on this thread instead.
+    const bool serial(m_pool->onWorker());
 
-        std::size_t dimNum(0);
-        const auto& mid(m_reader.metadata().boundsScaledCubic().mid());
+    std::exception_ptr error;
 
-        for (const auto& dim : m_outSchema.dims())
+    try
+    {
+        for (const auto& c : chunks)
         {
-            // Subtract one to ignore Dimension::Id::Unknown.
-            dimNum = pdal::Utils::toNative(dim.id()) - 1;
-
-            // Up to this point, everything has been in our local coordinate
-            // system.  Query bounds were transformed to match our local view
-            // of the world, as well as spatial attributes in the filter.  Now
-            // that we've selected a point in our own local space, finally we
-            // will transform that selection into user-requested space.
-            if (m_delta && dimNum < 3)
-            {
-                double d(m_pointRef.getFieldAs<double>(dim.id()));
+            const ChunkReader* cr(c.second);
+            if (!cr) throw std::runtime_error("Reservation failure");
 
-                // Center the point around the origin, scale it, then un-center
-                // it and apply the user's offset from the origin bounds center.
-                d = Point::scale(
-                        d,
-                        mid[dimNum],
-                        m_delta->scale()[dimNum],
-                        m_delta->offset()[dimNum]);
+            std::vector<char>& output(outputs[scans.size()]);
 
-                switch (dim.type())
-                {
-                    case pdal::Dimension::Type::Double:
-                        std::memcpy(pos, &d, 8);
-                        break;
-                    case pdal::Dimension::Type::Float:
-                        setSpatial<float>(pos, d);
-                        break;
-                    case pdal::Dimension::Type::Unsigned8:
-                        setSpatial<uint8_t>(pos, d);
-                        break;
-                    case pdal::Dimension::Type::Signed8:
-                        setSpatial<int8_t>(pos, d);
-                        break;
-                    case pdal::Dimension::Type::Unsigned16:
-                        setSpatial<uint16_t>(pos, d);
-                        break;
-                    case pdal::Dimension::Type::Signed16:
-                        setSpatial<int16_t>(pos, d);
-                        break;
-                    case pdal::Dimension::Type::Unsigned32:
-                        setSpatial<uint32_t>(pos, d);
-                        break;
-                    case pdal::Dimension::Type::Signed32:
-                        setSpatial<int32_t>(pos, d);
-                        break;
-                    case pdal::Dimension::Type::Unsigned64:
-                        setSpatial<uint64_t>(pos, d);
-                        break;
-                    case pdal::Dimension::Type::Signed64:
-                        setSpatial<int64_t>(pos, d);
-                        break;
-                    default:
-                        break;
-                }
-            }
-            else
-            {
-                m_pointRef.getField(pos, dim.id(), dim.type());
-            }
+            auto task(
+                    std::make_shared<std::packaged_task<void()>>(
+                        [this, cr, &output]() { scan(*cr, output); }));
 
-            pos += dim.size();
+            std::future<void> result(task->get_future());
+
+            if (serial) (*task)();
+            else m_pool->add([task]() { (*task)(); });
+
+            scans.push_back(std::move(result));
         }
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    // Our outputs must outlive every submitted scan, even if one of them, or
+    // a submission, has thrown.
+    for (auto& s : scans) s.wait();
+    if (error) std::rethrow_exception(error);
+    for (auto& s : scans) s.get();
+
+    const std::size_t pointSize(m_outSchema.pointSize());
+
+    for (const std::vector<char>& output : outputs)
+    {
+        buffer.insert(buffer.end(), output.begin(), output.end());
+        m_numPoints += output.size() / pointSize;
+    }
+}
+
+void Query::scan(const ChunkReader& cr, std::vector<char>& output) const
+{
+    BinaryPointTable table(m_reader.metadata().schema());
+    pdal::PointRef pointRef(table, 0);
 
+    std::vector<std::size_t> selection;
+    cr.select(m_queryBounds, cr.candidates(m_queryBounds), selection);
+    m_filter.select(cr, selection);
+
+    const std::size_t pointSize(m_outSchema.pointSize());
+    output.resize(selection.size() * pointSize);
+    char* pos(output.data());
+
+    for (const std::size_t i : selection)
+    {
+        processSelected(pos, cr.pointData(i), table, pointRef);
+        pos += pointSize;
+    }
+}
+
+FetchInfoSet Query::nextFetches()
+{
+    const auto begin(m_chunks.begin());
+    auto end(m_chunks.begin());
+    std::advance(end, std::min(fetchesPerIteration, m_chunks.size()));
+
+    FetchInfoSet subset(begin, end);
+    m_chunks.erase(begin, end);
+    return subset;
+}
+
+void Query::prefetch()
+{
+    // These acquisitions wait on Cache admission without holding a thread,
+    // and continue on the Cache's executor.  Our current block is released
+    // before we wait on the next one, so an in-flight prefetch never needs
+    // budget that only we can free.
+    using Promise = std::promise<std::unique_ptr<Block>>;
+    const std::string path(m_reader.path());
+
+    while (m_chunks.size() && m_prefetches.size() < m_prefetchWindow)
+    {
+        auto promise(std::make_shared<Promise>());
+        m_prefetches.push_back(promise->get_future());
+
+        m_cache.acquire(
+                path,
+                nextFetches(),
+                [promise](std::unique_ptr<Block> block, std::exception_ptr e)
+                {
+                    if (e) promise->set_exception(e);
+                    else promise->set_value(std::move(block));
+                });
+    }
+}
+
+void Query::setAs(char* pos, double d, pdal::Dimension::Type type) const
+{
+    switch (type)
+    {
+        case pdal::Dimension::Type::Double:
+            std::memcpy(pos, &d, 8);
+            break;
+        case pdal::Dimension::Type::Float:
+            setSpatial<float>(pos, d);
+            break;
+        case pdal::Dimension::Type::Unsigned8:
+            setSpatial<uint8_t>(pos, d);
+            break;
+        case pdal::Dimension::Type::Signed8:
+            setSpatial<int8_t>(pos, d);
+            break;
+        case pdal::Dimension::Type::Unsigned16:
+            setSpatial<uint16_t>(pos, d);
+            break;
+        case pdal::Dimension::Type::Signed16:
+            setSpatial<int16_t>(pos, d);
+            break;
+        case pdal::Dimension::Type::Unsigned32:
+            setSpatial<uint32_t>(pos, d);
+            break;
+        case pdal::Dimension::Type::Signed32:
+            setSpatial<int32_t>(pos, d);
+            break;
+        case pdal::Dimension::Type::Unsigned64:
+            setSpatial<uint64_t>(pos, d);
+            break;
+        case pdal::Dimension::Type::Signed64:
+            setSpatial<int64_t>(pos, d);
+            break;
+        default:
+            break;
+    }
+}
+
+bool Query::processPoint(std::vector<char>& buffer, const PointInfo& info)
+{
+    if (
+            m_queryBounds.contains(info.point()) &&
+            m_filter.check(info.data()))
+    {
+        const std::size_t initial(buffer.size());
+        buffer.resize(initial + m_outSchema.pointSize());
+        processSelected(buffer.data() + initial, info.data());
         return true;
     }
     else
@@ -324,5 +751,68 @@ bool Query::processPoint(std::vector<char>& buffer, const PointInfo& info)
     }
 }
 
-} // namespace entwine
+void Query::processSelected(char* pos, const char* data)
+{
+    processSelected(pos, data, m_table, m_pointRef);
+}
+
+void Query::processSelected(
+        char* pos,
+        const char* data,
+        BinaryPointTable& table,
+        pdal::PointRef& pointRef) const
+{
+    table.setPoint(data);
+
+    std::size_t dimNum(0);
+    std::size_t outNum(0);
+    const auto& mid(m_reader.metadata().boundsScaledCubic().mid());
+
+    for (const auto& dim : m_outSchema.dims())
+    {
+        // Subtract one to ignore Dimension::Id::Unknown.
+        dimNum = pdal::Utils::toNative(dim.id()) - 1;
+
+        // Up to this point, everything has been in our local coordinate
+        // system.  Query bounds were transformed to match our local view
+        // of the world, as well as spatial attributes in the filter.  Now
+        // that we've selected a point in our own local space, finally we
+        // will transform that selection into user-requested space.
+        if (m_delta && dimNum < 3)
+        {
+            double d(pointRef.getFieldAs<double>(dim.id()));
+
+            // Center the point around the origin, scale it, then un-center
+            // it and apply the user's offset from the origin bounds center.
+            d = Point::scale(
+                    d,
+                    mid[dimNum],
+                    m_delta->scale()[dimNum],
+                    m_delta->offset()[dimNum]);
+
+            setAs(pos, d, dim.type());
+        }
+        else if (const Constant* constant = m_constants[outNum])
+        {
+            // Copied exactly if it's requested at its own type.
+            if (constant->type() == dim.type())
+            {
+                std::memcpy(pos, constant->data(), dim.size());
+            }
+            else
+            {
+                setAs(pos, constant->value(), dim.type());
+            }
+        }
+        else
+        {
+            pointRef.getField(pos, dim.id(), dim.type());
+        }
+
+        pos += dim.size();
+        ++outNum;
+    }
 
+}
+
+} // namespace entwine
@@ -13,10 +13,19 @@
 #include <cassert>
 #include <cstddef>
 #include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <entwine/reader/cache.hpp>
 #include <entwine/reader/comparison.hpp>
 #include <entwine/reader/filter.hpp>
+#include <entwine/reader/query-cache.hpp>
+#include <entwine/tree/hierarchy.hpp>
 #include <entwine/types/binary-point-table.hpp>
 #include <entwine/types/delta.hpp>
 #include <entwine/types/dir.hpp>
@@ -27,8 +36,9 @@ namespace entwine
 {
 
 class Cache;
+class ChunkReader;
 class PointInfo;
-class PointState;
+class Pool;
 class Reader;
 class Schema;
 
@@ -118,6 +128,8 @@ public:
             const Point* scale = nullptr,
             const Point* offset = nullptr);
 
+    ~Query();
+
     std::vector<char> run()
     {
         std::vector<char> buffer;
@@ -125,28 +137,142 @@ public:
         return buffer;
     }
 
+    // Stream the results to sink rather than collecting them all in memory.
+    // The buffer passed to sink is reused, and holds at most pagePoints
+    // points from chunked data, or a single chunk's worth if pagePoints is
+    // zero.  Points from the base, whose size is bounded by the base depth,
+    // arrive as one page.
+    void run(
+            const std::function<void(const std::vector<char>&)>& sink,
+            std::size_t pagePoints);
+
     // Returns true if next() should be called again.  If false is returned,
     // then the query is complete and next() should not be called anymore.
     bool next(std::vector<char>& buffer);
 
+    using Done = std::function<void(std::vector<char>, std::exception_ptr)>;
+
+    // Run query to completion without blocking on the Cache.  Each block of
+    // chunks is acquired asynchronously, and the query resumes on executor
+    // once it arrives, so a few threads may drive many queries.  done is
+    // called once, with the results or the error that ended the query.  The
+    // base, which is resident once loaded, is still queried inline.  This is
+    // called in place of next().
+    static void runAsync(
+            std::shared_ptr<Query> query,
+            Pool& executor,
+            Done done);
+
     bool done() const { return m_done; }
+    std::size_t depthBegin() const { return m_depthBegin; }
+    std::size_t depthEnd() const { return m_depthEnd; }
     std::size_t numPoints() const { return m_numPoints; }
 
+    // Estimated from the hierarchy when the query is constructed, this is the
+    // number of points in the chunks to be fetched that overlap the query,
+    // before filtering.  Points in the base, or in chunks shallower than the
+    // hierarchy, are not included.  Zero if our results are served from the
+    // Cache's QueryCache.
+    std::size_t plannedPoints() const { return m_plannedPoints; }
+
+    // True if our results are served from the Cache's QueryCache, in which
+    // case they are appended by a single call to next().
+    bool cached() const { return static_cast<bool>(m_cached); }
+
+    // Number of upcoming blocks of chunks to fetch in the background while
+    // the current block is processed.  Zero fetches each block only when it
+    // is needed.  Defaults to one.
+    void prefetchWindow(std::size_t blocks) { m_prefetchWindow = blocks; }
+
+    // Cap the number of chunked points appended by each call to next().
+    // Zero, the default, appends a full chunk per call.
+    void pagePoints(std::size_t points) { m_pagePoints = points; }
+
+    // Scan the chunks of each block in parallel on pool, which may be shared
+    // with other queries.  Each chunk is written to its own buffer, and these
+    // are appended in the same order as a serial scan.  Each call to next()
+    // then appends a full block, regardless of pagePoints.  Set this before
+    // the first call to next().  A call to next() made from a task of pool
+    // itself, as when pool also drives runAsync, scans its block serially
+    // rather than waiting on pool.
+    void parallel(Pool& pool) { m_pool = &pool; }
+
+    // Stop after this many points, discarding the rest of the page that
+    // reaches it.  Points arrive in depth order, so the points kept are the
+    // coarsest.  Zero, the default, is unlimited.
+    void pointLimit(std::size_t points) { m_pointLimit = points; }
+
 protected:
-    bool getBase(std::vector<char>& buffer); // True if base data existed.
+    void getBase(std::vector<char>& buffer);
     void getChunked(std::vector<char>& buffer);
 
-    void getFetches(const QueryChunkState& chunkState);
-    void getBase(std::vector<char>& buffer, const PointState& pointState);
+    // Chunks to be fetched, with their estimated point counts.
+    using Candidates = std::vector<std::pair<FetchInfo, uint64_t>>;
+
+    // Counted from the hierarchy nodes of the parent chunk, if it had any.
+    void getFetches(
+            const QueryChunkState& chunkState,
+            const Hierarchy::Nodes* parents,
+            Candidates& candidates) const;
+
+    // Keep the candidates whose statistics don't rule out every point.  The
+    // statistics of all of them are fetched together.
+    void select(const Candidates& candidates);
+
+    // Identifies our results within the QueryCache.  Parameters are taken
+    // after they've been localized and clipped to the index, so equivalent
+    // queries share a key.
+    std::string cacheKey(const Json::Value& filter) const;
+
+    // Copy the output appended by a call to next() from initial onward, and
+    // if we're finished, store it in the QueryCache.
+    void record(const std::vector<char>& buffer, std::size_t initial);
+
+    // Trim buffer to m_pointLimit and finish, if we've reached it, releasing
+    // everything we've acquired.
+    void limit(std::vector<char>& buffer);
+
+    struct AsyncRun;
 
-    template<typename T> void setSpatial(char* pos, double d)
+    // Acquire our next block for runAsync, or finish if we're done.
+    static void acquireNext(std::shared_ptr<AsyncRun> run);
+
+    // Remove the next block's worth of fetches from m_chunks.
+    FetchInfoSet nextFetches();
+
+    // Start acquiring blocks until m_prefetchWindow are in flight.
+    void prefetch();
+
+    // Release our current block, then wait for and release each prefetched
+    // block in turn.  Prefetches are admitted in order, so each may need the
+    // budget of those before it, but never that of those after.
+    void release();
+
+    template<typename T> void setSpatial(char* pos, double d) const
     {
         const T v(d);
         std::memcpy(pos, &v, sizeof(T));
     }
 
+    void setAs(char* pos, double d, pdal::Dimension::Type type) const;
+
     bool processPoint(std::vector<char>& buffer, const PointInfo& info);
 
+    // Write a point already known to lie within the query bounds and to pass
+    // the filter in the output schema at pos.
+    void processSelected(char* pos, const char* data);
+    void processSelected(
+            char* pos,
+            const char* data,
+            BinaryPointTable& table,
+            pdal::PointRef& pointRef) const;
+
+    // Process every chunk of m_block on m_pool.
+    void processBlock(std::vector<char>& buffer);
+
+    // Thread-safe: select, filter, and write the points of a single chunk.
+    void scan(const ChunkReader& cr, std::vector<char>& output) const;
+
     const Reader& m_reader;
     const Structure& m_structure;
     Cache& m_cache;
@@ -158,9 +284,17 @@ protected:
 
     FetchInfoSet m_chunks;
     std::unique_ptr<Block> m_block;
+    std::deque<std::future<std::unique_ptr<Block>>> m_prefetches;
+    std::size_t m_prefetchWindow;
     ChunkMap::const_iterator m_chunkReaderIt;
+    std::vector<std::size_t> m_selection;
+    std::size_t m_selectionPos;
+    std::size_t m_pagePoints;
+    Pool* m_pool;
+    std::size_t m_pointLimit;
 
     std::size_t m_numPoints;
+    std::size_t m_plannedPoints;
 
     bool m_base;
     bool m_done;
@@ -171,6 +305,15 @@ protected:
     pdal::PointRef m_pointRef;
 
     Filter m_filter;
+
+    // Parallel to the output schema dimensions - non-null entries are
+    // synthesized from pruned constants rather than read from point data.
+    std::vector<const Constant*> m_constants;
+
+    std::string m_cacheKey;
+    QueryCache::Data m_cached;
+    std::vector<char> m_record;
+    bool m_recording;
 };
 
 } // namespace entwine
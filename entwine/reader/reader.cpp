@@ -10,6 +10,8 @@
 
 #include <entwine/reader/reader.hpp>
 
+#include <algorithm>
+#include <future>
 #include <numeric>
 
 #include <entwine/reader/cache.hpp>
@@ -21,6 +23,7 @@
 #include <entwine/tree/hierarchy.hpp>
 #include <entwine/tree/registry.hpp>
 #include <entwine/types/bounds.hpp>
+#include <entwine/types/chunk-stats.hpp>
 #include <entwine/types/manifest.hpp>
 #include <entwine/types/metadata.hpp>
 #include <entwine/types/reprojection.hpp>
@@ -55,43 +58,105 @@ Reader::Reader(const std::string path, Cache& cache)
 
 Reader::Reader(const arbiter::Endpoint& endpoint, Cache& cache)
     : m_endpoint(endpoint)
-    , m_metadata(makeUnique<Metadata>(m_endpoint))
-    , m_hierarchy(
-            makeUnique<Hierarchy>(
-                hierarchyPool,
-                *m_metadata,
-                endpoint,
-                nullptr,
-                true))
+    , m_ids(std::async(std::launch::async, fetchIds, m_endpoint).share())
+    , m_metadata(makeUnique<Metadata>(Metadata::fetch(m_endpoint, nullptr)))
+    , m_hierarchy()
     , m_base()
+    , m_baseFlag()
     , m_cache(cache)
-    , m_ids()
 {
-    const Structure& structure(m_metadata->structure());
+    // Our manifest and hierarchy each need only our metadata, so we fetch
+    // them concurrently.  The metadata itself is needed by both, so it can't
+    // overlap them, but it does overlap the chunk IDs.
+    std::future<std::unique_ptr<Manifest>> manifest(
+            std::async(std::launch::async, [this]()
+            {
+                return m_metadata->fetchManifest(m_endpoint);
+            }));
+
+    m_hierarchy = makeUnique<Hierarchy>(
+            hierarchyPool,
+            *m_metadata,
+            m_endpoint,
+            nullptr,
+            true);
+
+    m_metadata->m_manifest = manifest.get();
+
+    invalidateQueries();
+}
+
+Reader::~Reader()
+{ }
+
+Reader::ChunkIds Reader::fetchIds(const arbiter::Endpoint& endpoint)
+{
+    ChunkIds ids;
 
-    if (structure.hasBase())
+    if (auto data = endpoint.tryGet("entwine-ids"))
     {
+        ids.found = true;
+
+        for (const Id& id : extractIds(*data))
+        {
+            if (id.trivial()) ids.simple.push_back(id.getSimple());
+            else ids.big.push_back(id);
+        }
+
+        std::sort(ids.simple.begin(), ids.simple.end());
+        std::sort(ids.big.begin(), ids.big.end());
+    }
+
+    return ids;
+}
+
+const BaseChunkReader* Reader::base() const
+{
+    std::call_once(m_baseFlag, [this]()
+    {
+        const Structure& structure(m_metadata->structure());
+        if (!structure.hasBase()) return;
+
         auto compressed(
                 makeUnique<std::vector<char>>(
-                    endpoint.getBinary(structure.baseIndexBegin().str())));
+                    m_endpoint.getBinary(structure.baseIndexBegin().str())));
 
         m_base = makeUnique<BaseChunkReader>(
                 *m_metadata,
                 BaseChunk::makeCelled(m_metadata->schema()),
                 structure.baseIndexBegin(),
                 std::move(compressed));
+    });
+
+    return m_base.get();
+}
+
+bool Reader::exists(const Id& id) const
+{
+    const ChunkIds& ids(m_ids.get());
+
+    if (!ids.found && m_metadata->structure().hasCold())
+    {
+        throw std::runtime_error("Could not fetch entwine-ids");
     }
 
-    if (structure.hasCold())
+    if (id.trivial())
+    {
+        return std::binary_search(
+                ids.simple.begin(),
+                ids.simple.end(),
+                id.getSimple());
+    }
+    else
     {
-        auto ids(extractIds(m_endpoint.get("entwine-ids")));
-        m_ids.insert(ids.begin(), ids.end());
-        // std::cout << "Found " << m_ids.size() << " chunks" << std::endl;
+        return std::binary_search(ids.big.begin(), ids.big.end(), id);
     }
 }
 
-Reader::~Reader()
-{ }
+void Reader::invalidateQueries()
+{
+    m_cache.queryCache().invalidate(path());
+}
 
 Json::Value Reader::hierarchy(
         const Bounds& inBounds,
@@ -100,18 +165,119 @@ Json::Value Reader::hierarchy(
         const bool vertical,
         const Point* scale,
         const Point* offset)
+{
+    const HierarchyTree tree(
+            hierarchyTree(inBounds, depthBegin, depthEnd, scale, offset));
+
+    if (!vertical) return tree.toJson();
+
+    Json::Value json;
+    for (const uint64_t n : tree.depthCounts())
+    {
+        json.append(static_cast<Json::UInt64>(n));
+    }
+    return json;
+}
+
+std::vector<char> Reader::hierarchyBinary(
+        const Bounds& inBounds,
+        const std::size_t depthBegin,
+        const std::size_t depthEnd,
+        const bool vertical,
+        const Point* scale,
+        const Point* offset)
+{
+    const HierarchyTree tree(
+            hierarchyTree(inBounds, depthBegin, depthEnd, scale, offset));
+
+    return vertical ? tree.toVerticalBinary() : tree.toBinary();
+}
+
+HierarchyTree Reader::hierarchyTree(
+        const Bounds& inBounds,
+        const std::size_t depthBegin,
+        const std::size_t depthEnd,
+        const Point* scale,
+        const Point* offset)
 {
     checkQuery(depthBegin, depthEnd);
 
     const Bounds queryBounds(inBounds.undeltify(Delta(scale, offset)));
     Hierarchy::QueryResults results(
-            vertical ?
-                m_hierarchy->queryVertical(queryBounds, depthBegin, depthEnd) :
-                m_hierarchy->query(queryBounds, depthBegin, depthEnd));
+            m_hierarchy->query(queryBounds, depthBegin, depthEnd));
 
     m_cache.markHierarchy(m_endpoint.prefixedRoot(), results.touched);
 
-    return results.json;
+    return std::move(results.tree);
+}
+
+uint64_t Reader::count(
+        const Bounds& queryBounds,
+        const std::size_t depth,
+        const uint64_t limit) const
+{
+    Hierarchy::Slots touched;
+
+    const uint64_t n(
+            m_hierarchy->count(toNative(queryBounds), depth, limit, touched));
+
+    m_cache.markHierarchy(m_endpoint.prefixedRoot(), touched);
+
+    return n;
+}
+
+uint64_t Reader::count(
+        const Bounds& queryBounds,
+        const std::size_t depth,
+        const Hierarchy::Nodes* parents,
+        Hierarchy::Nodes& nodes) const
+{
+    Hierarchy::Slots touched;
+
+    const uint64_t n(
+            m_hierarchy->count(
+                toNative(queryBounds),
+                depth,
+                parents,
+                nodes,
+                touched));
+
+    m_cache.markHierarchy(m_endpoint.prefixedRoot(), touched);
+
+    return n;
+}
+
+Bounds Reader::toNative(const Bounds& queryBounds) const
+{
+    // Our chunks are indexed in scaled coordinates, but the hierarchy walks
+    // the native cube.  Both cubes are subdivided identically, so map our
+    // bounds by their relative position, with a bit of slack.
+    const Bounds& local(m_metadata->boundsScaledCubic());
+    const Bounds& native(m_metadata->boundsNativeCubic());
+
+    const auto map([&local, &native](const Point& p)
+    {
+        return Point(
+            native.min().x + (p.x - local.min().x) / local.width() *
+                native.width(),
+            native.min().y + (p.y - local.min().y) / local.depth() *
+                native.depth(),
+            native.min().z + (p.z - local.min().z) / local.height() *
+                native.height());
+    });
+
+    return Bounds(map(queryBounds.min()), map(queryBounds.max())).growBy(.01);
+}
+
+std::vector<std::shared_ptr<const ChunkStats>> Reader::stats(
+        const std::vector<Id>& chunkIds) const
+{
+    if (!metadata().format().chunkStats())
+    {
+        return std::vector<std::shared_ptr<const ChunkStats>>(chunkIds.size());
+    }
+
+    return m_cache.stats(*this, chunkIds);
 }
 
 std::unique_ptr<Query> Reader::getQuery(
@@ -193,6 +359,126 @@ std::unique_ptr<Query> Reader::getQuery(
 {
     checkQuery(depthBegin, depthEnd);
 
+    const Delta delta(localDelta(scale, offset));
+
+    return makeUnique<Query>(
+            *this,
+            schema,
+            filter,
+            m_cache,
+            localBounds(queryBounds, delta),
+            depthBegin,
+            depthEnd,
+            delta.exists() ? &delta.scale() : nullptr,
+            delta.exists() ? &delta.offset() : nullptr);
+}
+
+std::unique_ptr<Query> Reader::getBudgetedQuery(
+        const Bounds& qbox,
+        const std::size_t pointBudget,
+        const Point* scale,
+        const Point* offset)
+{
+    return getBudgetedQuery(
+            m_metadata->schema(),
+            Json::Value(),
+            qbox,
+            0,
+            pointBudget,
+            scale,
+            offset);
+}
+
+std::unique_ptr<Query> Reader::getBudgetedQuery(
+        const Schema& schema,
+        const Json::Value& filter,
+        const Bounds& queryBounds,
+        const std::size_t depthBegin,
+        const std::size_t pointBudget,
+        const Point* scale,
+        const Point* offset)
+{
+    const Bounds local(
+            localBounds(queryBounds, localDelta(scale, offset)).intersection(
+                m_metadata->boundsScaledCubic()));
+
+    const std::size_t depthEnd(
+            budgetDepthEnd(local, depthBegin, pointBudget));
+
+    std::unique_ptr<Query> query(
+            getQuery(
+                schema,
+                filter,
+                queryBounds,
+                depthBegin,
+                depthEnd,
+                scale,
+                offset));
+
+    query->pointLimit(pointBudget);
+    return query;
+}
+
+std::size_t Reader::budgetDepthEnd(
+        const Bounds& queryBounds,
+        const std::size_t depthBegin,
+        const std::size_t pointBudget) const
+{
+    const Structure& structure(m_metadata->structure());
+
+    uint64_t total(0);
+    std::size_t depth(depthBegin);
+
+    while (true)
+    {
+        uint64_t n(0);
+
+        if (structure.isWithinBase(depth))
+        {
+            // The base is resident once loaded, so count it exactly.
+            if (const BaseChunkReader* b = base())
+            {
+                const auto counter([&queryBounds, &n](const PointInfo& info)
+                {
+                    if (queryBounds.contains(info.point())) ++n;
+                });
+
+                b->query(queryBounds, depth, counter);
+            }
+        }
+        else if (depth >= structure.baseDepthEnd())
+        {
+            // Counting stops as soon as this depth is known not to fit, so
+            // the walk is bounded by the points we may still take.
+            n = count(queryBounds, depth, pointBudget - total);
+        }
+
+        if (total + n > pointBudget) break;
+
+        total += n;
+        ++depth;
+
+        // No points here means none deeper, except ahead of the base.
+        if (!n && depth > structure.baseDepthBegin()) break;
+    }
+
+    return std::max(depth, depthBegin + 1);
+}
+
+Delta Reader::localDelta(const Point* scale, const Point* offset) const
+{
+    const Delta indexDelta(m_metadata->delta());
+    const Delta queryDelta(scale, offset);
+
+    return Delta(
+            queryDelta.scale() / indexDelta.scale(),
+            queryDelta.offset() - indexDelta.offset());
+}
+
+Bounds Reader::localBounds(
+        const Bounds& queryBounds,
+        const Delta& localDelta) const
+{
     Bounds queryCube(queryBounds);
 
     if (!queryCube.is3d())
@@ -208,22 +494,7 @@ std::unique_ptr<Query> Reader::getQuery(
                     std::numeric_limits<double>::max()));
     }
 
-    const Delta indexDelta(m_metadata->delta());
-    const Delta queryDelta(scale, offset);
-    const Delta localDelta(
-            queryDelta.scale() / indexDelta.scale(),
-            queryDelta.offset() - indexDelta.offset());
-
-    return makeUnique<Query>(
-            *this,
-            schema,
-            filter,
-            m_cache,
-            localize(queryCube, localDelta),
-            depthBegin,
-            depthEnd,
-            localDelta.exists() ? &localDelta.scale() : nullptr,
-            localDelta.exists() ? &localDelta.offset() : nullptr);
+    return localize(queryCube, localDelta);
 }
 
 Bounds Reader::localize(
@@ -11,11 +11,12 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <future>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
-#include <set>
 #include <vector>
 
 #include <entwine/reader/query.hpp>
@@ -42,6 +43,7 @@ public:
 class BaseChunkReader;
 class Bounds;
 class Cache;
+class ChunkStats;
 class Hierarchy;
 class Metadata;
 class Schema;
@@ -61,6 +63,15 @@ public:
         return q->run();
     }
 
+    // The query is planned on the calling thread, and then run by
+    // Query::runAsync.
+    template<typename... Args>
+    void queryAsync(Pool& executor, Query::Done done, Args&&... args)
+    {
+        std::shared_ptr<Query> q(getQuery(std::forward<Args>(args)...));
+        Query::runAsync(q, executor, done);
+    }
+
     std::unique_ptr<Query> getQuery(
             std::size_t depth,
             const Point* scale = nullptr,
@@ -102,6 +113,26 @@ public:
             const Point* scale = nullptr,
             const Point* offset = nullptr);
 
+    // Rather than ending at a fixed depth, these queries end at the deepest
+    // depth for which the hierarchy counts at most pointBudget points within
+    // qbox from depthBegin onward.  Results arrive coarsest-first, and the
+    // query stops after pointBudget points, which may end partway through a
+    // depth if a filter or the hierarchy's estimates leave more than that.
+    std::unique_ptr<Query> getBudgetedQuery(
+            const Bounds& qbox,
+            std::size_t pointBudget,
+            const Point* scale = nullptr,
+            const Point* offset = nullptr);
+
+    std::unique_ptr<Query> getBudgetedQuery(
+            const Schema& schema,
+            const Json::Value& filter,
+            const Bounds& qbox,
+            std::size_t depthBegin,
+            std::size_t pointBudget,
+            const Point* scale = nullptr,
+            const Point* offset = nullptr);
+
     Json::Value hierarchy(
             const Bounds& qbox,
             std::size_t depthBegin,
@@ -110,26 +141,111 @@ public:
             const Point* scale = nullptr,
             const Point* offset = nullptr);
 
+    // The same results as hierarchy, in the binary encodings of
+    // HierarchyTree::toBinary or, if vertical, toVerticalBinary.
+    std::vector<char> hierarchyBinary(
+            const Bounds& qbox,
+            std::size_t depthBegin,
+            std::size_t depthEnd,
+            bool vertical = false,
+            const Point* scale = nullptr,
+            const Point* offset = nullptr);
+
     const Metadata& metadata() const { return *m_metadata; }
     std::string path() const { return m_endpoint.root(); }
 
-    const BaseChunkReader* base() const { return m_base.get(); }
+    // The base is fetched and indexed by the first call, which may block.
+    // Returns nullptr if there is no base.
+    const BaseChunkReader* base() const;
+
     const arbiter::Endpoint& endpoint() const { return m_endpoint; }
-    bool exists(const Id& id) const { return m_ids.count(id); }
+
+    // Blocks until the chunk IDs, which are fetched as we're opened, arrive.
+    bool exists(const Id& id) const;
+
+    // Drop the cached results of queries against this index.  This is done
+    // when a Reader is opened, in case the index has changed since.
+    void invalidateQueries();
+
+    // Count the points at depth within queryBounds, given in the same local
+    // coordinates as our chunks, from the hierarchy.  This may overestimate.
+    // Counting stops once the count exceeds limit, so a result greater than
+    // limit means only that the count exceeds it.
+    uint64_t count(
+            const Bounds& queryBounds,
+            std::size_t depth,
+            uint64_t limit) const;
+
+    // As above, but without a limit, collecting the hierarchy nodes counted
+    // so that the next depth may be counted from them as parents - see
+    // Hierarchy::count.  Depths prior to the start of the hierarchy are
+    // Hierarchy::uncounted.
+    uint64_t count(
+            const Bounds& queryBounds,
+            std::size_t depth,
+            const Hierarchy::Nodes* parents,
+            Hierarchy::Nodes& nodes) const;
+
+    // Statistics for each of chunkIds, in the same order, through our Cache.
+    // Entries are nullptr for chunks without any, which is all of them if
+    // this index was built without them.
+    std::vector<std::shared_ptr<const ChunkStats>> stats(
+            const std::vector<Id>& chunkIds) const;
 
 private:
+    // Local query bounds mapped, with some slack, onto the native cube walked
+    // by our hierarchy.
+    Bounds toNative(const Bounds& queryBounds) const;
+
+    // The query delta relative to our own.
+    Delta localDelta(const Point* scale, const Point* offset) const;
+
+    // Query bounds in the coordinates of our chunks, with 2d bounds extended
+    // to cover every Z value.
+    Bounds localBounds(const Bounds& inBounds, const Delta& localDelta) const;
+
     Bounds localize(
             const Bounds& inBounds,
             const Delta& localDelta) const;
 
+    // The end of the deepest depth range from depthBegin whose points within
+    // queryBounds, in local coordinates, fit within pointBudget.  At least
+    // one depth is always included.
+    std::size_t budgetDepthEnd(
+            const Bounds& queryBounds,
+            std::size_t depthBegin,
+            std::size_t pointBudget) const;
+
+    HierarchyTree hierarchyTree(
+            const Bounds& qbox,
+            std::size_t depthBegin,
+            std::size_t depthEnd,
+            const Point* scale,
+            const Point* offset);
+
+    // The IDs of our cold chunks, sorted.  Those that don't fit in 64 bits
+    // are rare, so they're kept apart.
+    struct ChunkIds
+    {
+        bool found = false;
+        std::vector<uint64_t> simple;
+        std::vector<Id> big;
+    };
+
+    static ChunkIds fetchIds(const arbiter::Endpoint& endpoint);
+
     arbiter::Endpoint m_endpoint;
 
+    // Started before our metadata is fetched, so they download concurrently.
+    std::shared_future<ChunkIds> m_ids;
+
     std::unique_ptr<Metadata> m_metadata;
     std::unique_ptr<Hierarchy> m_hierarchy;
-    std::unique_ptr<BaseChunkReader> m_base;
+
+    mutable std::unique_ptr<BaseChunkReader> m_base;
+    mutable std::once_flag m_baseFlag;
 
     Cache& m_cache;
-    std::set<Id> m_ids;
 };
 
 } // namespace entwine
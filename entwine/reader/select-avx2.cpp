@@ -0,0 +1,67 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#include <entwine/reader/select-avx2.hpp>
+
+#include <stdexcept>
+
+#ifdef ENTWINE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace entwine
+{
+namespace avx2
+{
+
+#ifdef ENTWINE_AVX2
+
+namespace
+{
+    __m256d between(const __m256d v, const double lo, const double hi)
+    {
+        return _mm256_and_pd(
+                _mm256_cmp_pd(v, _mm256_set1_pd(lo), _CMP_GE_OQ),
+                _mm256_cmp_pd(v, _mm256_set1_pd(hi), _CMP_LT_OQ));
+    }
+}
+
+int within(
+        const double* x,
+        const double* y,
+        const double* z,
+        const Point& min,
+        const Point& max)
+{
+    return _mm256_movemask_pd(
+            _mm256_and_pd(
+                between(_mm256_loadu_pd(x), min.x, max.x),
+                _mm256_and_pd(
+                    between(_mm256_loadu_pd(y), min.y, max.y),
+                    between(_mm256_loadu_pd(z), min.z, max.z))));
+}
+
+#else
+
+int within(
+        const double*,
+        const double*,
+        const double*,
+        const Point&,
+        const Point&)
+{
+    throw std::runtime_error("Built without AVX2 support");
+}
+
+#endif
+
+} // namespace avx2
+} // namespace entwine
+
@@ -0,0 +1,36 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <entwine/types/point.hpp>
+
+namespace entwine
+{
+
+// This is the only code compiled with AVX2 enabled, when ENTWINE_AVX2 is set,
+// so nothing else may require it of the CPU.  Callers must check for AVX2 at
+// runtime before calling it.
+namespace avx2
+{
+
+// Bit i of the result is set if point i of the four given by x, y, and z is
+// within [min, max) along every axis.
+int within(
+        const double* x,
+        const double* y,
+        const double* z,
+        const Point& min,
+        const Point& max);
+
+} // namespace avx2
+
+} // namespace entwine
+
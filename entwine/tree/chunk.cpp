@@ -25,6 +25,7 @@
 #include <entwine/types/pooled-point-table.hpp>
 #include <entwine/types/subset.hpp>
 #include <entwine/util/compression.hpp>
+#include <entwine/util/json.hpp>
 #include <entwine/util/storage.hpp>
 #include <entwine/util/unique.hpp>
 
@@ -35,6 +36,36 @@ namespace
 {
     std::atomic_size_t chunkCount(0);
     const std::string tubeIdDim("TubeId");
+
+    // Spread the low 21 bits of v so two zero bits separate each of them.
+    uint64_t spread(uint64_t v)
+    {
+        v &= 0x1fffff;
+        v = (v | v << 32) & 0x1f00000000ffffULL;
+        v = (v | v << 16) & 0x1f0000ff0000ffULL;
+        v = (v | v << 8) & 0x100f00f00f00f00fULL;
+        v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+        v = (v | v << 2) & 0x1249249249249249ULL;
+        return v;
+    }
+
+    // Quantize a coordinate to 21 bits across the given range.
+    uint64_t quantize(double v, double min, double max)
+    {
+        static const double cells(1 << 21);
+        if (max <= min) return 0;
+
+        const double q(std::floor((v - min) / (max - min) * cells));
+        return std::max(0.0, std::min(cells - 1, q));
+    }
+
+    uint64_t mortonCode(const Point& p, const Bounds& b)
+    {
+        return
+            spread(quantize(p.x, b.min().x, b.max().x)) |
+            spread(quantize(p.y, b.min().y, b.max().y)) << 1 |
+            spread(quantize(p.z, b.min().z, b.max().z)) << 2;
+    }
 }
 
 std::size_t Chunk::count() { return chunkCount; }
@@ -54,6 +85,7 @@ Chunk::Chunk(
     , m_id(id)
     , m_maxPoints(maxPoints)
     , m_data()
+    , m_stats()
 {
     ++chunkCount;
 }
@@ -82,11 +114,84 @@ void Chunk::collect(ChunkType type)
     Cell::PooledStack cellStack(acquire());
     Data::PooledStack dataStack(m_pointPool.dataPool());
 
-    for (Cell& cell : cellStack) dataStack.push(cell.acquire());
+    const Format& format(m_metadata.format());
+    const bool ticked(format.hasTailField(TailField::Ticks));
+    const bool morton(format.mortonOrder());
+
+    if (!ticked && !morton)
+    {
+        for (Cell& cell : cellStack) dataStack.push(cell.acquire());
+        cellStack.reset();
+
+        if (format.chunkStats())
+        {
+            m_stats = makeUnique<ChunkStats>(m_metadata.schema(), dataStack);
+        }
+
+        m_data = format.pack(std::move(dataStack), type);
+        return;
+    }
+
+    // Order our points by tick so a reader may select a range of ticks as a
+    // contiguous range of points, without indexing them itself.  Within each
+    // tick, optionally order them along a Morton curve so neighboring records
+    // are spatially close, which helps both compression and query scans.
+    const Bounds& bounds(m_metadata.boundsScaledCubic());
+
+    struct KeyedCell
+    {
+        uint64_t tick;
+        uint64_t code;
+        Cell* cell;
+    };
+
+    std::vector<KeyedCell> keyed;
+    keyed.reserve(cellStack.size());
+
+    for (Cell& cell : cellStack)
+    {
+        const Point point(cell.point());
+        keyed.push_back(KeyedCell {
+                ticked ? Tube::calcTick(point, bounds, m_depth) : 0,
+                morton ? mortonCode(point, m_bounds) : 0,
+                &cell });
+    }
+
+    std::stable_sort(
+            keyed.begin(),
+            keyed.end(),
+            [](const KeyedCell& a, const KeyedCell& b)
+            {
+                return a.tick < b.tick || (a.tick == b.tick && a.code < b.code);
+            });
+
+    TickIndex ticks;
+    uint64_t offset(0);
+
+    for (const KeyedCell& k : keyed)
+    {
+        if (ticks.empty() || ticks.back().tick != k.tick)
+        {
+            ticks.push_back(TickEntry { k.tick, offset });
+        }
+
+        offset += k.cell->size();
+    }
+
+    // Pushing onto a stack prepends, so push in reverse to end up ascending.
+    for (auto it(keyed.rbegin()); it != keyed.rend(); ++it)
+    {
+        dataStack.push(it->cell->acquire());
+    }
 
     cellStack.reset();
 
-    m_data = m_metadata.format().pack(std::move(dataStack), type);
+    if (format.chunkStats())
+    {
+        m_stats = makeUnique<ChunkStats>(m_metadata.schema(), dataStack);
+    }
+
+    m_data = format.pack(std::move(dataStack), type, ticked ? &ticks : nullptr);
 }
 
 Chunk::~Chunk()
@@ -98,6 +203,14 @@ Chunk::~Chunk()
                 m_metadata.postfix(true));
 
         Storage::ensurePut(m_builder.outEndpoint(), path, *m_data);
+
+        if (m_stats)
+        {
+            Storage::ensurePut(
+                    m_builder.outEndpoint(),
+                    ChunkStats::path(m_metadata, m_id),
+                    toFastString(m_stats->toJson()));
+        }
     }
 
     if (chunkCount) --chunkCount;
@@ -502,7 +615,7 @@ BaseChunk::BaseChunk(const Builder& builder, Unpacker unpacker)
         std::copy(pos + dataOffset, pos + celledPointSize, *data);
 
         Cell::PooledNode cell(cellStack.popOne());
-        cell->set(pointRef, std::move(data));
+        cell->set(std::move(data), m_pointPool.cellLayout());
 
         const std::size_t tube(pointRef.getFieldAs<uint64_t>(tubeId));
         const std::size_t curDepth(ChunkInfo::calcDepth(factor, m_id + tube));
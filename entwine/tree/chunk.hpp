@@ -22,6 +22,7 @@
 #include <entwine/formats/cesium/tile-info.hpp>
 #include <entwine/formats/cesium/util.hpp>
 #include <entwine/tree/climber.hpp>
+#include <entwine/types/chunk-stats.hpp>
 #include <entwine/types/dim-info.hpp>
 #include <entwine/types/format.hpp>
 #include <entwine/types/point.hpp>
@@ -119,6 +120,7 @@ protected:
     const Id m_maxPoints;
 
     std::unique_ptr<std::vector<char>> m_data;
+    std::unique_ptr<ChunkStats> m_stats;
 };
 
 class SparseChunk : public Chunk
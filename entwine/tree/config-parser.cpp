@@ -108,6 +108,8 @@ std::unique_ptr<Builder> ConfigParser::getBuilder(
     }
 
     const bool compress(json["compress"].asUInt64());
+    const bool mortonOrder(json["mortonOrder"].asBool());
+    const bool chunkStats(json["chunkStats"].asBool());
     const bool trustHeaders(json["trustHeaders"].asBool());
     auto cesiumSettings(getCesiumSettings(json["formats"]));
     bool absolute(json["absolute"].asBool());
@@ -133,6 +135,18 @@ std::unique_ptr<Builder> ConfigParser::getBuilder(
     auto boundsConforming(maybeCreate<Bounds>(json["bounds"]));
     auto schema(maybeCreate<Schema>(json["schema"]));
 
+    // Constant dimensions only apply to the schema they were pruned from, so
+    // they are taken from the config only alongside a pre-supplied schema.
+    Constants constants;
+    if (schema)
+    {
+        const Json::Value& c(json["constants"]);
+        for (const auto& k : c.getMemberNames())
+        {
+            constants.emplace(k, Constant(c[k]));
+        }
+    }
+
     const bool needsInference(!boundsConforming || !schema || !numPointsHint);
 
     if (needsInference)
@@ -153,6 +167,7 @@ std::unique_ptr<Builder> ConfigParser::getBuilder(
                 !!cesiumSettings,
                 arbiter.get());
 
+        inference.pruneConstants(json["pruneConstants"].asBool());
         inference.go();
 
         // Overwrite our initial fileInfo with the inferred version, which
@@ -186,14 +201,19 @@ std::unique_ptr<Builder> ConfigParser::getBuilder(
 
         if (!schema)
         {
+            constants = inference.constants();
+
             auto dims(inference.schema().dims());
             if (delta)
             {
-                const Bounds cube(
-                        Metadata::makeScaledCube(
+                const Bounds scaled(
+                        Metadata::makeScaledEpsilon(
                             *boundsConforming,
                             delta.get()));
-                dims = Schema::deltify(cube, *delta, inference.schema()).dims();
+                dims = Schema::deltify(
+                        scaled,
+                        *delta,
+                        inference.schema()).dims();
             }
 
             const std::size_t pointIdSize([&fileInfo]()
@@ -235,8 +255,15 @@ std::unique_ptr<Builder> ConfigParser::getBuilder(
     json["numPointsHint"] = static_cast<Json::UInt64>(numPointsHint);
     Structure structure(json);
     Structure hierarchyStructure(Hierarchy::structure(structure, subset.get()));
+
+    // Unless specified, compress the hierarchy with LZMA if we're compressing
+    // the point data.
     const HierarchyCompression hierarchyCompression(
-            compress ? HierarchyCompression::Lzma : HierarchyCompression::None);
+            json.isMember("compressHierarchy") ?
+                hierarchyCompressionFromName(
+                    json["compressHierarchy"].asString()) :
+                compress ?
+                    HierarchyCompression::Lzma : HierarchyCompression::None);
 
     const auto ep(arbiter->getEndpoint(json["output"].asString()));
     const Manifest manifest(fileInfo, ep);
@@ -249,12 +276,15 @@ std::unique_ptr<Builder> ConfigParser::getBuilder(
             manifest,
             trustHeaders,
             compress,
+            mortonOrder,
+            chunkStats,
             hierarchyCompression,
             reprojection.get(),
             subset.get(),
             delta.get(),
             transformation.get(),
-            cesiumSettings.get());
+            cesiumSettings.get(),
+            &constants);
 
     OuterScope outerScope;
     outerScope.setArbiter(arbiter);
@@ -354,7 +384,16 @@ void ConfigParser::normalizeInput(
 
         input = inference["fileInfo"];
 
-        if (!json.isMember("schema")) json["schema"] = inference["schema"];
+        if (!json.isMember("schema"))
+        {
+            json["schema"] = inference["schema"];
+
+            if (inference.isMember("constants"))
+            {
+                json["constants"] = inference["constants"];
+            }
+        }
+
         if (!json.isMember("bounds")) json["bounds"] = inference["bounds"];
         if (!json.isMember("numPointsHint"))
         {
@@ -19,6 +19,7 @@
 #include <entwine/util/compression.hpp>
 #include <entwine/util/storage.hpp>
 #include <entwine/util/unique.hpp>
+#include <entwine/util/varint.hpp>
 
 namespace entwine
 {
@@ -26,6 +27,50 @@ namespace entwine
 namespace
 {
     std::atomic_size_t chunkCount(0);
+
+    // Map signed deltas to unsigned so small negative values stay small.
+    uint64_t zigzag(const int64_t val)
+    {
+        return (static_cast<uint64_t>(val) << 1) ^ (val < 0 ? ~0ULL : 0ULL);
+    }
+
+    int64_t unzigzag(const uint64_t val)
+    {
+        return static_cast<int64_t>(val >> 1) ^ -static_cast<int64_t>(val & 1);
+    }
+
+    // Varint layout of a tube: the number of cells, followed by each cell as
+    // a tick delta from the previous tick of this tube and then its count.
+    void pushTube(std::vector<char>& data, const HierarchyTube& tube)
+    {
+        pushVarint(data, tube.size());
+
+        uint64_t last(0);
+        for (const auto& cell : tube)
+        {
+            pushVarint(data, cell.first - last);
+            pushVarint(data, cell.second->val());
+            last = cell.first;
+        }
+    }
+
+    // A tube's map node along with its pooled cell.
+    const std::size_t cellBytes(
+            sizeof(HierarchyTube::value_type) + 4 * sizeof(void*) +
+            sizeof(HierarchyCell::RawNode));
+
+    template<typename Op>
+    void extractTube(const char*& pos, const char* end, Op op)
+    {
+        const uint64_t cells(extractVarint(pos, end));
+        uint64_t tick(0);
+
+        for (uint64_t i(0); i < cells; ++i)
+        {
+            tick += extractVarint(pos, end);
+            op(tick, extractVarint(pos, end));
+        }
+    }
 }
 
 std::size_t HierarchyBlock::count() { return chunkCount; }
@@ -97,6 +142,10 @@ std::unique_ptr<HierarchyBlock> HierarchyBlock::create(
     {
         decompressed = Compression::decompressLzma(data);
     }
+    else if (compress == HierarchyCompression::Zstd)
+    {
+        decompressed = Compression::decompressZstd(data);
+    }
 
     if (!id)
     {
@@ -137,10 +186,19 @@ void HierarchyBlock::save(const arbiter::Endpoint& ep, const std::string pf)
     {
         data = *Compression::compressLzma(data);
     }
+    else if (type == HierarchyCompression::Zstd)
+    {
+        data = *Compression::compressZstd(data);
+    }
 
     Storage::ensurePut(ep, m_id.str() + pf, data);
 }
 
+bool HierarchyBlock::varint() const
+{
+    return m_metadata.format().hierarchyEncoding() == HierarchyEncoding::Varint;
+}
+
 ContiguousBlock::ContiguousBlock(
         HierarchyCell::Pool& pool,
         const Metadata& metadata,
@@ -155,6 +213,24 @@ ContiguousBlock::ContiguousBlock(
     const char* pos(data.data());
     const char* end(data.data() + data.size());
 
+    if (varint())
+    {
+        uint64_t tube(0);
+
+        while (pos < end)
+        {
+            tube += extractVarint(pos, end);
+            HierarchyTube& curr(m_tubes.at(tube));
+
+            extractTube(pos, end, [this, &curr](uint64_t tick, uint64_t cell)
+            {
+                curr.insert(std::make_pair(tick, m_pool.acquireOne(cell)));
+            });
+        }
+
+        return;
+    }
+
     uint64_t tube, tick, cell;
 
     auto extract([&pos]()
@@ -178,6 +254,22 @@ std::vector<char> ContiguousBlock::combine()
 {
     std::vector<char> data;
 
+    if (varint())
+    {
+        std::size_t last(0);
+
+        for (std::size_t tube(0); tube < m_tubes.size(); ++tube)
+        {
+            if (m_tubes[tube].empty()) continue;
+
+            pushVarint(data, tube - last);
+            pushTube(data, m_tubes[tube]);
+            last = tube;
+        }
+
+        return data;
+    }
+
     for (std::size_t tube(0); tube < m_tubes.size(); ++tube)
     {
         for (const auto& cell : m_tubes[tube])
@@ -191,6 +283,18 @@ std::vector<char> ContiguousBlock::combine()
     return data;
 }
 
+std::size_t ContiguousBlock::bytes() const
+{
+    std::size_t bytes(
+            sizeof(ContiguousBlock) +
+            m_tubes.capacity() * sizeof(HierarchyTube) +
+            m_spinners.capacity() * sizeof(SpinLock));
+
+    for (const HierarchyTube& tube : m_tubes) bytes += tube.size() * cellBytes;
+
+    return bytes;
+}
+
 bool ContiguousBlock::empty() const
 {
     for (const auto& tube : m_tubes)
@@ -215,6 +319,27 @@ SparseBlock::SparseBlock(
     const char* pos(data.data());
     const char* end(data.data() + data.size());
 
+    if (varint())
+    {
+        std::vector<Id::Block> blocks;
+
+        while (pos < end)
+        {
+            blocks.resize(extractVarint(pos, end));
+            for (auto& b : blocks) b = extractVarint(pos, end);
+
+            const Id id(blocks.data(), blocks.data() + blocks.size());
+            HierarchyTube& curr(m_tubes[id]);
+
+            extractTube(pos, end, [this, &curr](uint64_t tick, uint64_t cell)
+            {
+                curr.insert(std::make_pair(tick, m_pool.acquireOne(cell)));
+            });
+        }
+
+        return;
+    }
+
     const Id::Block* tubePos(nullptr);
     uint64_t tubeBlocks, tubeBytes, tick, cell;
 
@@ -240,10 +365,37 @@ SparseBlock::SparseBlock(
     }
 }
 
+std::size_t SparseBlock::bytes() const
+{
+    std::size_t bytes(sizeof(SparseBlock));
+
+    for (const auto& p : m_tubes)
+    {
+        bytes += sizeof(p) + 4 * sizeof(void*) + p.second.size() * cellBytes;
+    }
+
+    return bytes;
+}
+
 std::vector<char> SparseBlock::combine()
 {
     std::vector<char> data;
 
+    if (varint())
+    {
+        for (const auto& pair : m_tubes)
+        {
+            const Id& id(pair.first);
+            if (pair.second.empty()) continue;
+
+            pushVarint(data, id.data().size());
+            for (const Id::Block block : id.data()) pushVarint(data, block);
+            pushTube(data, pair.second);
+        }
+
+        return data;
+    }
+
     for (const auto& pair : m_tubes)
     {
         const Id& id(pair.first);
@@ -329,6 +481,29 @@ BaseBlock::BaseBlock(
     const char* pos(data.data());
     const char* end(data.data() + data.size());
 
+    const std::size_t factor(m_metadata.hierarchyStructure().factor());
+
+    if (varint())
+    {
+        int64_t index(0);
+
+        while (pos < end)
+        {
+            index += unzigzag(extractVarint(pos, end));
+
+            const Id id(m_id + static_cast<uint64_t>(index));
+            const std::size_t depth(ChunkInfo::calcDepth(factor, id));
+            ContiguousBlock& block(m_blocks.at(depth));
+
+            extractTube(pos, end, [&block, &id](uint64_t tick, uint64_t cell)
+            {
+                block.count(id, tick, cell);
+            });
+        }
+
+        return;
+    }
+
     uint64_t tube, tick, cell;
 
     auto extract([&pos]()
@@ -338,8 +513,6 @@ BaseBlock::BaseBlock(
         return v;
     });
 
-    const std::size_t factor(m_metadata.hierarchyStructure().factor());
-
     while (pos < end)
     {
         tube = extract();
@@ -352,6 +525,13 @@ BaseBlock::BaseBlock(
     }
 }
 
+std::size_t BaseBlock::bytes() const
+{
+    std::size_t bytes(sizeof(BaseBlock));
+    for (const ContiguousBlock& block : m_blocks) bytes += block.bytes();
+    return bytes;
+}
+
 std::vector<char> BaseBlock::combine()
 {
     // Pretty much the same as ContiguousBlock::combine, but normalized
@@ -360,6 +540,32 @@ std::vector<char> BaseBlock::combine()
 
     makeWritable();
 
+    if (varint())
+    {
+        // Writes may not be in ascending index order, so deltas are signed.
+        int64_t last(0);
+
+        for (const auto& write : m_writes)
+        {
+            for (const auto& block : write)
+            {
+                const auto& tubes(block.tubes());
+
+                for (std::size_t tube(0); tube < tubes.size(); ++tube)
+                {
+                    if (tubes[tube].empty()) continue;
+
+                    const int64_t index((block.id() + tube).getSimple());
+                    pushVarint(data, zigzag(index - last));
+                    pushTube(data, tubes[tube]);
+                    last = index;
+                }
+            }
+        }
+
+        return data;
+    }
+
     for (const auto& write : m_writes)
     {
         for (const auto& block : write)
@@ -99,6 +99,9 @@ public:
     const Id& id() const { return m_id; }
     const Id& maxPoints() const { return m_maxPoints; }
 
+    // Approximate heap bytes held by this block.  Not thread-safe.
+    virtual std::size_t bytes() const = 0;
+
 protected:
     Id normalize(const Id& id) const { return id - m_id; }
 
@@ -112,6 +115,9 @@ protected:
 
     Id endId() const { return m_id + m_maxPoints; }
 
+    // True if our serialized blocks use HierarchyEncoding::Varint.
+    bool varint() const;
+
     virtual std::vector<char> combine() = 0;
 
     HierarchyCell::Pool& m_pool;
@@ -189,6 +195,8 @@ public:
 
     const std::vector<HierarchyTube>& tubes() const { return m_tubes; }
 
+    virtual std::size_t bytes() const override;
+
 private:
     virtual std::vector<char> combine() override;
 
@@ -236,6 +244,8 @@ public:
     std::vector<ContiguousBlock>& blocks() { return m_blocks; }
     const std::vector<ContiguousBlock>& blocks() const { return m_blocks; }
 
+    virtual std::size_t bytes() const override;
+
 private:
     virtual std::vector<char> combine() override;
 
@@ -304,6 +314,8 @@ public:
 
     const std::map<Id, HierarchyTube>& tubes() const { return m_tubes; }
 
+    virtual std::size_t bytes() const override;
+
 private:
     virtual std::vector<char> combine() override;
 
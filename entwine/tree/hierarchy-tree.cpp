@@ -0,0 +1,121 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#include <entwine/tree/hierarchy-tree.hpp>
+
+#include <entwine/util/varint.hpp>
+
+namespace entwine
+{
+
+constexpr std::size_t HierarchyTree::root;
+
+std::size_t HierarchyTree::child(const std::size_t node, const Dir dir)
+{
+    const std::size_t i(toIntegral(dir));
+
+    if (!m_nodes[node].children[i])
+    {
+        m_nodes[node].children[i] = m_nodes.size();
+        m_nodes.emplace_back();
+    }
+
+    return m_nodes[node].children[i];
+}
+
+std::vector<uint64_t> HierarchyTree::depthCounts() const
+{
+    std::vector<uint64_t> counts;
+    if (empty()) return counts;
+
+    // Breadth-first, one depth at a time.
+    std::vector<std::size_t> current(1, root);
+    std::vector<std::size_t> next;
+
+    while (!current.empty())
+    {
+        uint64_t total(0);
+
+        for (const std::size_t node : current)
+        {
+            total += m_nodes[node].n;
+
+            for (const uint32_t c : m_nodes[node].children)
+            {
+                if (c) next.push_back(c);
+            }
+        }
+
+        counts.push_back(total);
+        current.swap(next);
+        next.clear();
+    }
+
+    return counts;
+}
+
+Json::Value HierarchyTree::toJson() const
+{
+    Json::Value json;
+    if (!empty()) toJson(json, root);
+    return json;
+}
+
+void HierarchyTree::toJson(Json::Value& json, const std::size_t node) const
+{
+    const Node& current(m_nodes[node]);
+    json["n"] = static_cast<Json::UInt64>(current.n);
+
+    for (std::size_t i(0); i < dirEnd(); ++i)
+    {
+        if (const std::size_t c = current.children[i])
+        {
+            toJson(json[dirToString(toDir(i))], c);
+        }
+    }
+}
+
+std::vector<char> HierarchyTree::toBinary() const
+{
+    std::vector<char> data;
+    if (!empty()) toBinary(data, root);
+    return data;
+}
+
+void HierarchyTree::toBinary(
+        std::vector<char>& data,
+        const std::size_t node) const
+{
+    const Node& current(m_nodes[node]);
+    pushVarint(data, current.n);
+
+    uint8_t mask(0);
+    for (std::size_t i(0); i < dirEnd(); ++i)
+    {
+        if (current.children[i]) mask |= 1 << i;
+    }
+
+    data.push_back(static_cast<char>(mask));
+
+    for (const uint32_t c : current.children)
+    {
+        if (c) toBinary(data, c);
+    }
+}
+
+std::vector<char> HierarchyTree::toVerticalBinary() const
+{
+    std::vector<char> data;
+    for (const uint64_t n : depthCounts()) pushVarint(data, n);
+    return data;
+}
+
+} // namespace entwine
+
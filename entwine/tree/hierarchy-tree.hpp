@@ -0,0 +1,77 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <json/json.h>
+
+#include <entwine/types/dir.hpp>
+
+namespace entwine
+{
+
+// The point counts resulting from a hierarchy query, as a tree whose nodes
+// are stored contiguously and address their children by Dir.  Nodes are only
+// created for counts greater than zero.
+class HierarchyTree
+{
+public:
+    HierarchyTree() : m_nodes(1) { }
+
+    static constexpr std::size_t root = 0;
+
+    void add(std::size_t node, uint64_t inc) { m_nodes[node].n += inc; }
+
+    // Returns the child of node in direction dir, creating it if necessary.
+    // Indices remain valid as the tree grows, but references do not.
+    std::size_t child(std::size_t node, Dir dir);
+
+    bool empty() const { return !m_nodes[root].n; }
+
+    // Total counts at each depth, starting from the root.
+    std::vector<uint64_t> depthCounts() const;
+
+    // Nested objects with the count of each node under "n", and each child
+    // under the name of its Dir.  Empty trees are null.
+    Json::Value toJson() const;
+
+    // A pre-order encoding of the tree: each node is written as its count,
+    // as an unsigned LEB128 varint, followed by a single byte with bit i set
+    // if the node has a child in Dir i, followed by those children in order
+    // of increasing Dir.  Empty trees produce no bytes.
+    std::vector<char> toBinary() const;
+
+    // The counts of depthCounts, each as an unsigned LEB128 varint.
+    std::vector<char> toVerticalBinary() const;
+
+private:
+    struct Node
+    {
+        Node() : n(0), children() { }
+
+        uint64_t n;
+
+        // Zero for absent children, since the root is never a child.
+        std::array<uint32_t, dirEnd()> children;
+    };
+
+    void toJson(Json::Value& json, std::size_t node) const;
+    void toBinary(std::vector<char>& data, std::size_t node) const;
+
+    std::vector<Node> m_nodes;
+};
+
+} // namespace entwine
+
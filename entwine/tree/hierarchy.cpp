@@ -10,6 +10,8 @@
 
 #include <entwine/tree/hierarchy.hpp>
 
+#include <future>
+
 #include <entwine/tree/climber.hpp>
 #include <entwine/tree/cold.hpp>
 #include <entwine/tree/heuristics.hpp>
@@ -21,10 +23,7 @@
 namespace entwine
 {
 
-namespace
-{
-    const std::string countKey("n");
-}
+constexpr uint64_t Hierarchy::uncounted;
 
 Hierarchy::Hierarchy(
         HierarchyCell::Pool& pool,
@@ -207,8 +206,13 @@ void Hierarchy::save(Pool& pool) const
 {
     if (!m_outpoint) return;
 
+    // The base block is typically much larger than any single cold block, so
+    // save it alongside the cold blocks rather than ahead of them.
     const std::string topPostfix(m_metadata.postfix());
-    m_base.t->save(*m_outpoint, topPostfix);
+    auto base(std::async(std::launch::async, [this, &topPostfix]()
+    {
+        m_base.t->save(*m_outpoint, topPostfix);
+    }));
 
     const std::string coldPostfix(m_metadata.postfix(true));
     iterateCold([this, &coldPostfix](
@@ -219,6 +223,8 @@ void Hierarchy::save(Pool& pool) const
         if (slot.t) slot.t->save(*m_outpoint, coldPostfix);
     }, &pool);
 
+    base.get();
+
     Json::Value json;
     for (const auto& id : ids()) json.append(id.str());
     Storage::ensurePut(*m_outpoint, "ids" + topPostfix, toFastString(json));
@@ -266,44 +272,112 @@ Hierarchy::QueryResults Hierarchy::query(
     std::deque<Dir> lag;
 
     QueryResults results;
-    traverse(results.json, results.touched, query, pointState, lag);
+    traverse(results.tree, results.touched, query, pointState, lag);
     return results;
 }
 
-Hierarchy::QueryResults Hierarchy::queryVertical(
+uint64_t Hierarchy::count(
         const Bounds& queryBounds,
-        const std::size_t depthBegin,
-        const std::size_t depthEnd)
+        const std::size_t depth,
+        const uint64_t limit,
+        Slots& touched) const
 {
-    QueryResults results(query(queryBounds, depthBegin, depthEnd));
-    std::vector<std::size_t> out;
-    reduce(out, 0, results.json);
-    results.json = Json::Value();
-    for (const auto n : out) results.json.append(static_cast<Json::UInt64>(n));
-    return results;
+    if (depth < m_structure.startDepth()) return limit + 1;
+
+    PointState pointState(m_structure, m_bounds, m_structure.startDepth());
+    uint64_t total(0);
+
+    count(
+            queryBounds,
+            depth - m_structure.startDepth(),
+            pointState,
+            limit,
+            total,
+            touched);
+
+    return total;
 }
 
-void Hierarchy::reduce(
-        std::vector<std::size_t>& out,
-        std::size_t depth,
-        const Json::Value& in) const
+uint64_t Hierarchy::count(
+        const Bounds& queryBounds,
+        const std::size_t depth,
+        const Nodes* parents,
+        Nodes& nodes,
+        Slots& touched) const
 {
-    if (const std::size_t n = in["n"].asUInt64())
+    nodes.clear();
+
+    if (depth < m_structure.startDepth()) return uncounted;
+
+    const std::size_t target(depth - m_structure.startDepth());
+    const uint64_t limit(std::numeric_limits<uint64_t>::max());
+    uint64_t total(0);
+
+    if (!parents)
     {
-        if (out.size() <= depth) out.resize(depth + 1, 0);
-        out.at(depth) += n;
+        PointState pointState(m_structure, m_bounds, m_structure.startDepth());
+        count(queryBounds, target, pointState, limit, total, touched, &nodes);
+        return total;
+    }
 
-        ++depth;
+    for (const PointState& parent : *parents)
+    {
+        assert(parent.depth() + 1 == target);
 
-        for (const auto& k : in.getMemberNames())
+        for (std::size_t i(0); i < dirEnd(); ++i)
         {
-            if (k != "n") reduce(out, depth, in[k]);
+            count(
+                    queryBounds,
+                    target,
+                    parent.getClimb(toDir(i)),
+                    limit,
+                    total,
+                    touched,
+                    &nodes);
         }
     }
+
+    return total;
+}
+
+void Hierarchy::count(
+        const Bounds& queryBounds,
+        const std::size_t depth,
+        const PointState& pointState,
+        const uint64_t limit,
+        uint64_t& total,
+        Slots& touched,
+        Nodes* nodes) const
+{
+    if (total > limit || !queryBounds.overlaps(pointState.bounds())) return;
+
+    maybeTouch(touched, pointState);
+
+    // Nodes without points have no descendants with points either.
+    const uint64_t n(tryGet(pointState));
+    if (!n) return;
+
+    if (pointState.depth() == depth)
+    {
+        total += n;
+        if (nodes) nodes->push_back(pointState);
+        return;
+    }
+
+    for (std::size_t i(0); i < dirEnd(); ++i)
+    {
+        count(
+                queryBounds,
+                depth,
+                pointState.getClimb(toDir(i)),
+                limit,
+                total,
+                touched);
+    }
 }
 
 void Hierarchy::traverse(
-        Json::Value& json,
+        HierarchyTree& tree,
         Slots& ids,
         const Hierarchy::Query& query,
         const PointState& pointState,
@@ -329,7 +403,7 @@ void Hierarchy::traverse(
                 const Dir dir(toDir(i));
                 auto curlag(lag);
                 curlag.push_back(dir);
-                traverse(json, ids, query, pointState.getClimb(dir), curlag);
+                traverse(tree, ids, query, pointState.getClimb(dir), curlag);
             }
         }
         else
@@ -341,28 +415,36 @@ void Hierarchy::traverse(
                         pointState.bounds().mid(),
                         query.bounds().mid()));
 
-            traverse(json, ids, query, pointState.getClimb(dir), lag);
+            traverse(tree, ids, query, pointState.getClimb(dir), lag);
         }
     }
     else if (
             query.bounds().contains(pointState.bounds()) &&
             pointState.depth() < query.depthEnd())
     {
-        accumulate(json, ids, query, pointState, lag, inc);
+        accumulate(
+                tree,
+                HierarchyTree::root,
+                ids,
+                query,
+                pointState,
+                lag,
+                inc);
     }
 }
 
 void Hierarchy::accumulate(
-        Json::Value& json,
+        HierarchyTree& tree,
+        const std::size_t node,
         Slots& ids,
         const Hierarchy::Query& query,
         const PointState& pointState,
         std::deque<Dir>& lag,
         uint64_t inc)
 {
-    // Caller should not call if inc == 0 to avoid creating null keys.
+    // Caller should not call if inc == 0 to avoid creating empty nodes.
     maybeTouch(ids, pointState);
-    json[countKey] = json[countKey].asUInt64() + inc;
+    tree.add(node, inc);
 
     if (pointState.depth() + 1 >= query.depthEnd()) return;
 
@@ -375,8 +457,8 @@ void Hierarchy::accumulate(
 
             if (const uint64_t inc = tryGet(nextState))
             {
-                Json::Value& nextJson(json[dirToString(dir)]);
-                accumulate(nextJson, ids, query, nextState, lag, inc);
+                const std::size_t next(tree.child(node, dir));
+                accumulate(tree, next, ids, query, nextState, lag, inc);
             }
         }
     }
@@ -386,7 +468,7 @@ void Hierarchy::accumulate(
         lag.pop_front();
 
         // Don't traverse into lagdir until we've confirmed that a child exists.
-        Json::Value* nextJson(nullptr);
+        std::size_t next(HierarchyTree::root);
 
         for (std::size_t i(0); i < dirEnd(); ++i)
         {
@@ -395,11 +477,11 @@ void Hierarchy::accumulate(
 
             if (const uint64_t inc = tryGet(nextState))
             {
-                if (!nextJson) nextJson = &json[dirToString(lagdir)];
+                if (!next) next = tree.child(node, lagdir);
                 auto curlag(lag);
                 curlag.push_back(curdir);
 
-                accumulate(*nextJson, ids, query, nextState, curlag, inc);
+                accumulate(tree, next, ids, query, nextState, curlag, inc);
             }
         }
     }
@@ -13,6 +13,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <deque>
+#include <limits>
 #include <map>
 #include <mutex>
 #include <set>
@@ -23,6 +24,7 @@
 
 #include <entwine/third/arbiter/arbiter.hpp>
 #include <entwine/tree/hierarchy-block.hpp>
+#include <entwine/tree/hierarchy-tree.hpp>
 #include <entwine/tree/splitter.hpp>
 #include <entwine/types/bounds.hpp>
 #include <entwine/types/metadata.hpp>
@@ -81,7 +83,7 @@ public:
     using Slots = std::set<const Slot*>;
     struct QueryResults
     {
-        Json::Value json;
+        HierarchyTree tree;
         Slots touched;
     };
 
@@ -90,10 +92,35 @@ public:
             std::size_t depthBegin,
             std::size_t depthEnd);
 
-    QueryResults queryVertical(
+    // Count the points at the given depth in nodes overlapping queryBounds.
+    // Partially overlapping nodes are counted in full.  The walk stops once
+    // the count exceeds limit, so a result greater than limit is only a lower
+    // bound.  Depths prior to the start of the hierarchy cannot be counted,
+    // and are reported as exceeding limit.
+    uint64_t count(
             const Bounds& queryBounds,
-            std::size_t depthBegin,
-            std::size_t depthEnd);
+            std::size_t depth,
+            uint64_t limit,
+            Slots& touched) const;
+
+    // The nonempty nodes found at a single depth by a count, from which the
+    // next depth may be counted without walking from our root.
+    using Nodes = std::vector<PointState>;
+
+    // Returned by counts at depths prior to the start of the hierarchy.
+    static constexpr uint64_t uncounted = std::numeric_limits<uint64_t>::max();
+
+    // As above, but without a limit, collecting the nonempty nodes counted
+    // into nodes.  If parents is given, only its children are visited, so it
+    // must hold the nodes collected at the prior depth for bounds containing
+    // queryBounds.  Counting a query chunk by chunk in this way visits each
+    // node of the hierarchy about once, rather than once for each chunk.
+    uint64_t count(
+            const Bounds& queryBounds,
+            std::size_t depth,
+            const Nodes* parents,
+            Nodes& nodes,
+            Slots& touched) const;
 
     static Structure structure(
             const Structure& treeStructure,
@@ -123,24 +150,29 @@ private:
     };
 
     void traverse(
-            Json::Value& json,
+            HierarchyTree& tree,
             Slots& ids,
             const Query& query,
             const PointState& pointState,
             std::deque<Dir>& lag);
 
     void accumulate(
-            Json::Value& json,
+            HierarchyTree& tree,
+            std::size_t node,
             Slots& ids,
             const Query& query,
             const PointState& pointState,
             std::deque<Dir>& lag,
             uint64_t inc);
 
-    void reduce(
-            std::vector<std::size_t>& out,
+    void count(
+            const Bounds& queryBounds,
             std::size_t depth,
-            const Json::Value& in) const;
+            const PointState& pointState,
+            uint64_t limit,
+            uint64_t& total,
+            Slots& touched,
+            Nodes* nodes = nullptr) const;
 
     void maybeTouch(Slots& ids, const PointState& pointState) const;
 
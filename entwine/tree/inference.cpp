@@ -10,9 +10,12 @@
 
 #include <entwine/tree/inference.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <limits>
 
 #include <entwine/tree/config-parser.hpp>
+#include <entwine/types/metadata.hpp>
 #include <entwine/types/reprojection.hpp>
 #include <entwine/types/pooled-point-table.hpp>
 #include <entwine/util/matrix.hpp>
@@ -38,6 +41,19 @@ namespace
         dims.push_back(DimInfo("Z", "floating", 8));
         return Schema(dims);
     })());
+
+    // The type at which a dimension is stored, absent a configured schema.
+    pdal::Dimension::Type storedType(pdal::Dimension::Id id)
+    {
+        try
+        {
+            return pdal::Dimension::defaultType(id);
+        }
+        catch (pdal::pdal_error&)
+        {
+            return pdal::Dimension::Type::Double;
+        }
+    }
 }
 
 Inference::Inference(
@@ -344,12 +360,43 @@ void Inference::add(const std::string localPath, FileInfo& fileInfo)
             }
         }
 
+        if (m_pruneConstants)
+        {
+            std::size_t scannedPoints(0);
+            Bounds scannedBounds(Bounds::expander());
+
+            const bool scanned(
+                    scan(
+                        localPath,
+                        preview->dimNames,
+                        scannedPoints,
+                        scannedBounds));
+
+            if (m_trustHeaders)
+            {
+                update(preview->numPoints, preview->bounds, &preview->metadata);
+            }
+            else if (scanned)
+            {
+                update(scannedPoints, scannedBounds, nullptr);
+            }
+
+            return;
+        }
+
         if (m_trustHeaders)
         {
             update(preview->numPoints, preview->bounds, &preview->metadata);
             return;
         }
     }
+    else if (m_pruneConstants)
+    {
+        // Without a preview we don't know this file's dimensions, so we can't
+        // vouch for any of them being constant.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_scanValid = false;
+    }
 
     Bounds curBounds(Bounds::expander());
     std::size_t curNumPoints(0);
@@ -375,6 +422,116 @@ void Inference::add(const std::string localPath, FileInfo& fileInfo)
     }
 }
 
+bool Inference::scan(
+        const std::string& localPath,
+        const std::vector<std::string>& dimNames,
+        std::size_t& numPoints,
+        Bounds& bounds)
+{
+    // X, Y, and Z are always first, and are never candidates for pruning.
+    // The others are read at the types they'd be stored at, and compared
+    // bytewise, so values that would be stored differently never match.
+    DimList dims(xyzSchema.dims());
+    for (const auto& name : dimNames)
+    {
+        if (!xyzSchema.contains(name))
+        {
+            const pdal::Dimension::Id id(pdal::Dimension::id(name));
+            dims.emplace_back(name, id, storedType(id));
+        }
+    }
+
+    const Schema schema(dims);
+    PointPool pointPool(schema, nullptr);
+
+    std::vector<const pdal::Dimension::Detail*> details;
+    for (const auto& d : dims)
+    {
+        details.push_back(
+                schema.pdalLayout().dimDetail(schema.getId(d.name())));
+    }
+
+    std::vector<char> first(schema.pointSize());
+    std::vector<char> constant(dims.size(), true);
+
+    auto tracker([&](Cell::PooledStack stack)
+    {
+        for (const auto& cell : stack)
+        {
+            bounds.grow(cell.point());
+
+            for (const char* data : cell)
+            {
+                if (!numPoints)
+                {
+                    std::copy(data, data + first.size(), first.data());
+                }
+
+                for (std::size_t i(3); i < details.size(); ++i)
+                {
+                    const std::size_t offset(details[i]->offset());
+
+                    if (std::memcmp(
+                                data + offset,
+                                first.data() + offset,
+                                details[i]->size()))
+                    {
+                        constant[i] = false;
+                    }
+                }
+
+                ++numPoints;
+            }
+        }
+
+        return stack;
+    });
+
+    PooledPointTable pooledTable(pointPool, tracker, invalidOrigin);
+
+    const bool ran(
+            m_executor.run(
+                pooledTable,
+                localPath,
+                m_reproj.get(),
+                m_transformation.get()));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!ran)
+    {
+        m_scanValid = false;
+        return false;
+    }
+
+    if (!numPoints) return true;
+
+    ++m_scanned;
+
+    for (std::size_t i(3); i < dims.size(); ++i)
+    {
+        const std::string& name(dims[i].name());
+        ++m_constantCounts[name];
+
+        if (!constant[i])
+        {
+            m_varying.insert(name);
+        }
+        else
+        {
+            const Constant value(
+                    details[i]->type(),
+                    first.data() + details[i]->offset());
+
+            const auto it(m_constants.find(name));
+            if (it == m_constants.end()) m_constants.emplace(name, value);
+            else if (it->second != value) m_varying.insert(name);
+        }
+    }
+
+    return true;
+}
+
 void Inference::aggregate()
 {
     m_numPoints = makeUnique<std::size_t>(0);
@@ -439,31 +596,46 @@ void Inference::aggregate()
 
 void Inference::makeSchema()
 {
+    // A dimension is only constant if it was present, and held the same
+    // value, in every non-empty file.
+    Constants constants;
+    if (m_pruneConstants && m_scanValid)
+    {
+        for (const auto& c : m_constants)
+        {
+            if (
+                    !m_varying.count(c.first) &&
+                    m_constantCounts[c.first] == m_scanned)
+            {
+                constants.insert(c);
+
+                if (m_verbose)
+                {
+                    std::cout << "Pruning constant dimension " << c.first <<
+                        ": " << c.second.toJson()["value"] << std::endl;
+                }
+            }
+        }
+    }
+
+    m_constants = constants;
+
     DimList dims;
 
     for (const auto& name : m_dimVec)
     {
-        const pdal::Dimension::Id id(pdal::Dimension::id(name));
-
-        pdal::Dimension::Type t;
-        try
-        {
-            t = pdal::Dimension::defaultType(id);
-        }
-        catch (pdal::pdal_error&)
-        {
-            t = pdal::Dimension::Type::Double;
-        }
+        if (m_constants.count(name)) continue;
 
-        dims.emplace_back(name, id, t);
+        const pdal::Dimension::Id id(pdal::Dimension::id(name));
+        dims.emplace_back(name, id, storedType(id));
     }
 
     m_schema = makeUnique<Schema>(dims);
 
     if (const Delta* d = delta())
     {
-        const Bounds cube(m_bounds->cubeify(*d));
-        m_schema = makeUnique<Schema>(Schema::deltify(cube, *d, *m_schema));
+        const Bounds scaled(Metadata::makeScaledEpsilon(*m_bounds, d));
+        m_schema = makeUnique<Schema>(Schema::deltify(scaled, *d, *m_schema));
     }
 }
 
@@ -494,6 +666,10 @@ Json::Value Inference::toJson() const
     json["numPoints"] = Json::UInt64(numPoints());
     if (m_reproj) json["reprojection"] = m_reproj->toJson();
     if (m_delta) m_delta->insertInto(json);
+    for (const auto& c : m_constants)
+    {
+        json["constants"][c.first] = c.second.toJson();
+    }
     if (m_transformation)
     {
         json["transformation"] = toJsonArray(*m_transformation);
@@ -517,7 +693,13 @@ Inference::Inference(const Json::Value& json)
     , m_schema(makeUnique<Schema>(json["schema"]))
     , m_delta(Delta::maybeCreate(json))
     , m_fileInfo(toFileInfo(json["fileInfo"]))
-{ }
+{
+    const Json::Value& constants(json["constants"]);
+    for (const auto& k : constants.getMemberNames())
+    {
+        m_constants.emplace(k, Constant(constants[k]));
+    }
+}
 
 } // namespace entwine
 
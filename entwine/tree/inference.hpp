@@ -11,6 +11,7 @@
 #pragma once
 
 #include <cstddef>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -19,6 +20,7 @@
 
 #include <entwine/third/arbiter/arbiter.hpp>
 #include <entwine/types/bounds.hpp>
+#include <entwine/types/constant.hpp>
 #include <entwine/types/delta.hpp>
 #include <entwine/types/file-info.hpp>
 #include <entwine/types/schema.hpp>
@@ -73,6 +75,10 @@ public:
     void go();
     bool done() const { return m_done; }
 
+    // If set, every file is fully scanned during go() and dimensions holding
+    // a single value throughout the dataset are pruned from the schema.
+    void pruneConstants(bool prune) { m_pruneConstants = prune; }
+
     std::size_t index() const
     {
         std::lock_guard<std::mutex> lock(m_mutex);
@@ -85,6 +91,7 @@ public:
     std::size_t numPoints() const;
     const Reprojection* reprojection() const { return m_reproj.get(); }
     const Delta* delta() const { return m_delta.get(); }
+    const Constants& constants() const { return m_constants; }
 
     const std::vector<double>* transformation() const
     {
@@ -98,6 +105,11 @@ private:
     void makeSchema();  // Figure out schema and delta.
 
     void add(std::string localPath, FileInfo& fileInfo);
+    bool scan(
+            const std::string& localPath,
+            const std::vector<std::string>& dimNames,
+            std::size_t& numPoints,
+            Bounds& bounds);
     Transformation calcTransformation();
 
     Executor m_executor;
@@ -112,6 +124,7 @@ private:
     bool m_valid = false;
     bool m_done = false;
     bool m_cesiumify = false;
+    bool m_pruneConstants = false;
     std::unique_ptr<Transformation> m_transformation;
 
     std::unique_ptr<Pool> m_pool;
@@ -123,6 +136,13 @@ private:
     std::vector<std::string> m_dimVec;
     std::set<std::string> m_dimSet;
 
+    // Constant-dimension tracking, only used if m_pruneConstants is set.
+    Constants m_constants;
+    std::set<std::string> m_varying;
+    std::map<std::string, std::size_t> m_constantCounts;
+    std::size_t m_scanned = 0;
+    bool m_scanValid = true;
+
     std::unique_ptr<std::size_t> m_numPoints;
     std::unique_ptr<Bounds> m_bounds;
     std::unique_ptr<Schema> m_schema;
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <cassert>
+#include <exception>
 #include <memory>
 #include <mutex>
 
@@ -111,14 +112,34 @@ public:
         return results;
     }
 
+    // If a pool is supplied, op must be safe to run concurrently for distinct
+    // slots.  The first exception thrown by op is rethrown once the pool has
+    // drained, since pool tasks otherwise swallow their errors.
     template<typename Op>
     void iterateCold(Op op, Pool* pool = nullptr) const
     {
-        pool = nullptr;
-        auto call([&op, pool](const Id& id, std::size_t n, const Slot& slot)
+        std::mutex mutex;
+        std::exception_ptr error;
+
+        auto call([&op, &mutex, &error, pool](
+                    const Id& id,
+                    std::size_t n,
+                    const Slot& slot)
         {
-            if (pool) pool->add([&op, id, n, &slot]() { op(id, n, slot); });
-            else op(id, n, slot);
+            if (!pool) return op(id, n, slot);
+
+            pool->add([&op, &mutex, &error, id, n, &slot]()
+            {
+                try
+                {
+                    op(id, n, slot);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) error = std::current_exception();
+                }
+            });
         });
 
         for (std::size_t i(0); i < m_fast.size(); ++i)
@@ -132,6 +153,7 @@ public:
         for (const auto& p : m_slow) call(p.first, m_fast.size(), p.second);
 
         if (pool) pool->cycle();
+        if (error) std::rethrow_exception(error);
     }
 
     Slot& base() { return m_base; }
@@ -0,0 +1,178 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#include <entwine/types/chunk-stats.hpp>
+
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <pdal/PointRef.hpp>
+
+#include <entwine/types/binary-point-table.hpp>
+#include <entwine/types/metadata.hpp>
+#include <entwine/types/schema.hpp>
+#include <entwine/types/structure.hpp>
+
+namespace entwine
+{
+
+constexpr std::size_t DimStats::maxValues;
+
+DimStats::DimStats(const double min, const double max)
+    : m_min(min)
+    , m_max(max)
+    , m_tracked(false)
+    , m_values()
+{ }
+
+DimStats::DimStats(const Json::Value& json)
+    : m_min(json["min"].asDouble())
+    , m_max(json["max"].asDouble())
+    , m_tracked(json.isMember("values"))
+    , m_values()
+{
+    for (const Json::Value& v : json["values"]) addValue(v.asDouble());
+}
+
+bool DimStats::mayContain(const double v) const
+{
+    if (v < m_min || v > m_max) return false;
+    if (!m_tracked) return true;
+    if (v != std::floor(v)) return false;
+    return m_values.test(v - m_min);
+}
+
+void DimStats::addValue(const double v)
+{
+    m_values.set(v - m_min);
+}
+
+Json::Value DimStats::toJson() const
+{
+    Json::Value json;
+    json["min"] = m_min;
+    json["max"] = m_max;
+
+    if (m_tracked)
+    {
+        json["values"] = Json::arrayValue;
+
+        for (std::size_t i(0); i < maxValues; ++i)
+        {
+            if (m_values.test(i)) json["values"].append(m_min + i);
+        }
+    }
+
+    return json;
+}
+
+ChunkStats::ChunkStats(const Schema& schema, const Data::PooledStack& points)
+    : m_dims()
+{
+    if (points.empty()) return;
+
+    const DimList& dims(schema.dims());
+
+    BinaryPointTable table(schema);
+    pdal::PointRef pointRef(table, 0);
+
+    using Limits = std::numeric_limits<double>;
+    std::vector<double> mins(dims.size(), Limits::max());
+    std::vector<double> maxs(dims.size(), Limits::lowest());
+
+    for (const char* pos : points)
+    {
+        table.setPoint(pos);
+
+        for (std::size_t i(0); i < dims.size(); ++i)
+        {
+            const double v(pointRef.getFieldAs<double>(dims[i].id()));
+            mins[i] = std::min(mins[i], v);
+            maxs[i] = std::max(maxs[i], v);
+        }
+    }
+
+    // Integral dimensions with a narrow range get a second pass to record
+    // which of their values occur.
+    std::vector<std::pair<pdal::Dimension::Id, DimStats*>> tracked;
+
+    for (std::size_t i(0); i < dims.size(); ++i)
+    {
+        DimStats& stats(
+                m_dims.emplace(
+                    dims[i].name(),
+                    DimStats(mins[i], maxs[i])).first->second);
+
+        const bool integral(
+                pdal::Dimension::base(dims[i].type()) !=
+                pdal::Dimension::BaseType::Floating);
+
+        if (integral && maxs[i] - mins[i] < DimStats::maxValues)
+        {
+            stats.trackValues();
+            tracked.emplace_back(dims[i].id(), &stats);
+        }
+    }
+
+    if (tracked.empty()) return;
+
+    for (const char* pos : points)
+    {
+        table.setPoint(pos);
+
+        for (const auto& t : tracked)
+        {
+            t.second->addValue(pointRef.getFieldAs<double>(t.first));
+        }
+    }
+}
+
+ChunkStats::ChunkStats(const Json::Value& json)
+    : m_dims()
+{
+    for (const std::string& name : json.getMemberNames())
+    {
+        m_dims.emplace(name, DimStats(json[name]));
+    }
+}
+
+Json::Value ChunkStats::toJson() const
+{
+    Json::Value json;
+    for (const auto& p : m_dims) json[p.first] = p.second.toJson();
+    return json;
+}
+
+std::size_t ChunkStats::bytes() const
+{
+    // Each entry of our map is a separately allocated tree node.
+    const std::size_t nodeOverhead(4 * sizeof(void*));
+
+    std::size_t bytes(sizeof(ChunkStats));
+
+    for (const auto& p : m_dims)
+    {
+        bytes += nodeOverhead + sizeof(p) + p.first.capacity();
+    }
+
+    return bytes;
+}
+
+std::string ChunkStats::path(const Metadata& metadata, const Id& chunkId)
+{
+    return
+        metadata.structure().maybePrefix(chunkId) + "-stats" +
+        metadata.postfix(true);
+}
+
+} // namespace entwine
+
@@ -0,0 +1,86 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <map>
+#include <string>
+
+#include <json/json.h>
+
+#include <entwine/types/point-pool.hpp>
+
+namespace entwine
+{
+
+class Metadata;
+class Schema;
+
+// The range of the values of a single dimension over the points of a chunk.
+// For integral dimensions whose range spans fewer than maxValues values, the
+// values that actually occur are recorded as well.
+class DimStats
+{
+public:
+    static constexpr std::size_t maxValues = 256;
+
+    DimStats(double min, double max);
+    explicit DimStats(const Json::Value& json);
+
+    double min() const { return m_min; }
+    double max() const { return m_max; }
+
+    // Returns false only if no point of the chunk has the value v.
+    bool mayContain(double v) const;
+
+    void addValue(double v);
+    void trackValues() { m_tracked = true; }
+
+    Json::Value toJson() const;
+
+private:
+    double m_min;
+    double m_max;
+
+    bool m_tracked;
+    std::bitset<maxValues> m_values;
+};
+
+// Per-dimension statistics of the points of a chunk.  These are written
+// alongside each cold chunk at build time, so a query filter may rule out a
+// chunk without fetching it.
+class ChunkStats
+{
+public:
+    ChunkStats(const Schema& schema, const Data::PooledStack& points);
+    explicit ChunkStats(const Json::Value& json);
+
+    // Returns nullptr if there are no statistics for this dimension.
+    const DimStats* find(const std::string& name) const
+    {
+        const auto it(m_dims.find(name));
+        return it != m_dims.end() ? &it->second : nullptr;
+    }
+
+    Json::Value toJson() const;
+
+    // Approximate memory footprint, for caching.
+    std::size_t bytes() const;
+
+    static std::string path(const Metadata& metadata, const Id& chunkId);
+
+private:
+    std::map<std::string, DimStats> m_dims;
+};
+
+} // namespace entwine
+
@@ -0,0 +1,123 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#include <entwine/types/constant.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <entwine/types/dim-info.hpp>
+
+namespace entwine
+{
+
+namespace
+{
+    using Type = pdal::Dimension::Type;
+
+    template<typename T>
+    T get(const char* data)
+    {
+        T v;
+        std::memcpy(&v, data, sizeof(T));
+        return v;
+    }
+
+    template<typename T>
+    void set(T v, std::vector<char>& data)
+    {
+        data.resize(sizeof(T));
+        std::memcpy(data.data(), &v, sizeof(T));
+    }
+}
+
+Constant::Constant(const Json::Value& json)
+    : m_type(Type::Double)
+    , m_data()
+{
+    if (!json.isObject())
+    {
+        set(json.asDouble(), m_data);
+        return;
+    }
+
+    m_type = DimInfo("", json["type"].asString(), json["size"].asUInt64())
+        .type();
+
+    const Json::Value& v(json["value"]);
+
+    switch (m_type)
+    {
+        case Type::Double:      set(v.asDouble(), m_data); break;
+        case Type::Float:       set(v.asFloat(), m_data); break;
+        case Type::Signed8:     set<int8_t>(v.asInt(), m_data); break;
+        case Type::Signed16:    set<int16_t>(v.asInt(), m_data); break;
+        case Type::Signed32:    set<int32_t>(v.asInt(), m_data); break;
+        case Type::Signed64:    set<int64_t>(v.asInt64(), m_data); break;
+        case Type::Unsigned8:   set<uint8_t>(v.asUInt(), m_data); break;
+        case Type::Unsigned16:  set<uint16_t>(v.asUInt(), m_data); break;
+        case Type::Unsigned32:  set<uint32_t>(v.asUInt(), m_data); break;
+        case Type::Unsigned64:  set<uint64_t>(v.asUInt64(), m_data); break;
+        default: throw std::runtime_error("Invalid constant type");
+    }
+}
+
+Json::Value Constant::toJson() const
+{
+    const DimInfo dim("", pdal::Dimension::Id::Unknown, m_type);
+
+    Json::Value json;
+    json["type"] = dim.typeString();
+    json["size"] = static_cast<Json::UInt64>(dim.size());
+
+    const char* pos(data());
+    Json::Value& v(json["value"]);
+
+    switch (m_type)
+    {
+        case Type::Double:      v = get<double>(pos); break;
+        case Type::Float:       v = get<float>(pos); break;
+        case Type::Signed8:     v = get<int8_t>(pos); break;
+        case Type::Signed16:    v = get<int16_t>(pos); break;
+        case Type::Signed32:    v = get<int32_t>(pos); break;
+        case Type::Signed64:    v = Json::Int64(get<int64_t>(pos)); break;
+        case Type::Unsigned8:   v = get<uint8_t>(pos); break;
+        case Type::Unsigned16:  v = get<uint16_t>(pos); break;
+        case Type::Unsigned32:  v = get<uint32_t>(pos); break;
+        case Type::Unsigned64:  v = Json::UInt64(get<uint64_t>(pos)); break;
+        default: throw std::runtime_error("Invalid constant type");
+    }
+
+    return json;
+}
+
+double Constant::value() const
+{
+    const char* pos(data());
+
+    switch (m_type)
+    {
+        case Type::Double:      return get<double>(pos);
+        case Type::Float:       return get<float>(pos);
+        case Type::Signed8:     return get<int8_t>(pos);
+        case Type::Signed16:    return get<int16_t>(pos);
+        case Type::Signed32:    return get<int32_t>(pos);
+        case Type::Signed64:    return get<int64_t>(pos);
+        case Type::Unsigned8:   return get<uint8_t>(pos);
+        case Type::Unsigned16:  return get<uint16_t>(pos);
+        case Type::Unsigned32:  return get<uint32_t>(pos);
+        case Type::Unsigned64:  return get<uint64_t>(pos);
+        default: throw std::runtime_error("Invalid constant type");
+    }
+}
+
+} // namespace entwine
+
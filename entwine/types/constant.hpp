@@ -0,0 +1,64 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <pdal/Dimension.hpp>
+
+#include <json/json.h>
+
+namespace entwine
+{
+
+// The single value held by a dimension across an entire dataset.  The value
+// is kept as it was stored, at the dimension's type, so that 64-bit integers
+// survive intact - its JSON form holds that type alongside the exact value.
+class Constant
+{
+public:
+    Constant(pdal::Dimension::Type type, const char* data)
+        : m_type(type)
+        , m_data(data, data + pdal::Dimension::size(type))
+    { }
+
+    // Also accepts a bare number, taken as a double.
+    explicit Constant(const Json::Value& json);
+
+    Json::Value toJson() const;
+
+    pdal::Dimension::Type type() const { return m_type; }
+    const char* data() const { return m_data.data(); }
+
+    // This is only exact for types that fit within a double.
+    double value() const;
+
+    bool operator==(const Constant& other) const
+    {
+        return m_type == other.m_type && m_data == other.m_data;
+    }
+
+    bool operator!=(const Constant& other) const { return !(*this == other); }
+
+private:
+    pdal::Dimension::Type m_type;
+    std::vector<char> m_data;
+};
+
+// Dimensions found to hold a single value across an entire dataset, which are
+// dropped from the stored schema and synthesized on output.
+using Constants = std::map<std::string, Constant>;
+
+} // namespace entwine
+
@@ -10,7 +10,6 @@
 
 #include <entwine/types/format-packing.hpp>
 
-#include <entwine/types/binary-point-table.hpp>
 #include <entwine/types/delta.hpp>
 #include <entwine/types/format.hpp>
 #include <entwine/types/metadata.hpp>
@@ -39,17 +38,57 @@ std::vector<char> Packer::buildTail() const
             case TailField::ChunkType: append(tail, chunkType()); break;
             case TailField::NumPoints: append(tail, numPoints()); break;
             case TailField::NumBytes: append(tail, numBytes()); break;
+            case TailField::Ticks: append(tail, ticks()); break;
         }
     }
 
     return tail;
 }
 
+Packer::Data Packer::ticks() const
+{
+    const uint64_t count(m_ticks ? m_ticks->size() : 0);
+    Data data;
+
+    if (count)
+    {
+        const char* pos(reinterpret_cast<const char*>(m_ticks->data()));
+        data.assign(pos, pos + count * sizeof(TickEntry));
+    }
+
+    const char* pos(reinterpret_cast<const char*>(&count));
+    data.insert(data.end(), pos, pos + sizeof(uint64_t));
+
+    return data;
+}
+
 Unpacker::Unpacker(
         const Format& format,
         std::unique_ptr<std::vector<char>> data)
     : m_format(format)
     , m_data(std::move(data))
+    , m_begin(m_data ? m_data->data() : nullptr)
+    , m_size(m_data ? m_data->size() : 0)
+{
+    extractTail();
+
+    // Trim the tail from our owned copy so it may be handed off as-is.
+    m_data->resize(m_size);
+}
+
+Unpacker::Unpacker(
+        const Format& format,
+        const char* const data,
+        const std::size_t size)
+    : m_format(format)
+    , m_data()
+    , m_begin(data)
+    , m_size(size)
+{
+    extractTail();
+}
+
+void Unpacker::extractTail()
 {
     const auto& fields(m_format.tailFields());
 
@@ -61,12 +100,13 @@ Unpacker::Unpacker(
             case TailField::ChunkType: extractChunkType(); break;
             case TailField::NumPoints: extractNumPoints(); break;
             case TailField::NumBytes: extractNumBytes(); break;
+            case TailField::Ticks: extractTicks(); break;
         }
     }
 
     if (m_numBytes)
     {
-        if (*m_numBytes != m_data->size())
+        if (*m_numBytes != m_size)
         {
             throw std::runtime_error("Incorrect byte count");
         }
@@ -80,12 +120,14 @@ Unpacker::Unpacker(
     if (!m_numPoints)
     {
         m_numPoints = makeUnique<std::size_t>(
-                m_data->size() / m_format.schema().pointSize());
+                m_size / m_format.schema().pointSize());
     }
 }
 
 std::unique_ptr<std::vector<char>>&& Unpacker::acquireBytes()
 {
+    own();
+
     if (m_format.compress())
     {
         m_data = Compression::decompress(
@@ -102,6 +144,7 @@ Cell::PooledStack Unpacker::acquireCells(PointPool& pointPool)
     const auto np(numPoints());
     if (m_format.compress())
     {
+        own();
         auto d(Compression::decompress(*m_data, np, pointPool));
         m_data.reset();
         return d;
@@ -109,24 +152,19 @@ Cell::PooledStack Unpacker::acquireCells(PointPool& pointPool)
     else
     {
         const std::size_t pointSize(m_format.schema().pointSize());
-        BinaryPointTable table(m_format.schema());
-        pdal::PointRef pointRef(table, 0);
-
         Data::PooledStack dataStack(pointPool.dataPool().acquire(np));
         Cell::PooledStack cellStack(pointPool.cellPool().acquire(np));
 
         Cell::RawNode* cell(cellStack.head());
 
-        const char* pos(m_data->data());
+        const char* pos(m_begin);
 
         for (std::size_t i(0); i < np; ++i)
         {
-            table.setPoint(pos);
-
             Data::PooledNode data(dataStack.popOne());
             std::copy(pos, pos + pointSize, *data);
 
-            (*cell)->set(pointRef, std::move(data));
+            (*cell)->set(std::move(data), pointPool.cellLayout());
             cell = cell->next();
 
             pos += pointSize;
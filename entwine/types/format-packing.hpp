@@ -26,11 +26,13 @@ public:
             const TailFields& tailFields,
             const std::vector<char>& data,
             std::size_t numPoints,
-            ChunkType chunkType)
+            ChunkType chunkType,
+            const TickIndex* ticks = nullptr)
         : m_fields(tailFields)
         , m_data(data)
         , m_numPoints(numPoints)
         , m_chunkType(chunkType)
+        , m_ticks(ticks)
     { }
 
     std::vector<char> buildTail() const;
@@ -56,10 +58,15 @@ private:
         return Data(pos, pos + sizeof(uint64_t));
     }
 
+    // Serialized as the (tick, offset) pairs followed by their count, so it
+    // may be extracted from the back.
+    Data ticks() const;
+
     const TailFields& m_fields;
     const std::vector<char>& m_data;
     const std::size_t m_numPoints;
     const ChunkType m_chunkType;
+    const TickIndex* m_ticks;
 };
 
 class Unpacker
@@ -73,9 +80,16 @@ public:
     // Not decompressed - just the raw data without the tail.
     std::unique_ptr<std::vector<char>>&& acquireRawBytes()
     {
+        own();
         return std::move(m_data);
     }
 
+    // Raw data without the tail, valid for the lifetime of the underlying
+    // buffer.  This does not copy, even if the Unpacker was constructed over
+    // borrowed memory (for example a memory-mapped chunk).
+    const char* rawData() const { return m_begin; }
+    std::size_t rawSize() const { return m_size; }
+
     const ChunkType chunkType() const
     {
         if (m_chunkType) return *m_chunkType;
@@ -83,15 +97,21 @@ public:
     }
     const std::size_t numPoints() const { return *m_numPoints; }
 
+    // Null if this format has no tick index in its tail.
+    const TickIndex* ticks() const { return m_ticks.get(); }
+
 private:
     Unpacker(const Format& format, std::unique_ptr<std::vector<char>> data);
+    Unpacker(const Format& format, const char* data, std::size_t size);
+
+    void extractTail();
 
     void extractChunkType()
     {
         checkSize(1);
         m_chunkType = makeUnique<ChunkType>(
-                static_cast<ChunkType>(m_data->back()));
-        m_data->pop_back();
+                static_cast<ChunkType>(m_begin[m_size - 1]));
+        --m_size;
     }
 
     void extractNumPoints()
@@ -104,34 +124,61 @@ private:
         m_numBytes = makeUnique<std::size_t>(extract64());
     }
 
+    void extractTicks()
+    {
+        const std::size_t count(extract64());
+        const std::size_t size(count * sizeof(TickEntry));
+        checkSize(size);
+
+        m_ticks = makeUnique<TickIndex>(count);
+        const char* pos(m_begin + m_size - size);
+        std::copy(pos, pos + size, reinterpret_cast<char*>(m_ticks->data()));
+
+        m_size -= size;
+    }
+
     uint64_t extract64()
     {
         const std::size_t size(sizeof(uint64_t));
         checkSize(size);
         uint64_t val(0);
 
-        const char* pos(m_data->data() + m_data->size() - size);
+        const char* pos(m_begin + m_size - size);
         std::copy(pos, pos + size, reinterpret_cast<char*>(&val));
 
-        m_data->resize(m_data->size() - size);
+        m_size -= size;
         return val;
     }
 
     void checkSize(std::size_t minimum)
     {
-        if (!m_data || m_data->size() < minimum)
+        if (!m_begin || m_size < minimum)
         {
             throw std::runtime_error("Invalid chunk size");
         }
     }
 
+    // If we are only borrowing our bytes, copy them so they may be handed
+    // off to the caller.
+    void own()
+    {
+        if (!m_data && m_begin)
+        {
+            m_data = makeUnique<std::vector<char>>(m_begin, m_begin + m_size);
+            m_begin = m_data->data();
+        }
+    }
+
     const Format& m_format;
 
     std::unique_ptr<std::vector<char>> m_data;
+    const char* m_begin;
+    std::size_t m_size;
 
     std::unique_ptr<ChunkType> m_chunkType;
     std::unique_ptr<std::size_t> m_numPoints;
     std::unique_ptr<std::size_t> m_numBytes;
+    std::unique_ptr<TickIndex> m_ticks;
 };
 
 } // namespace entwine
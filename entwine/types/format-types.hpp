@@ -11,6 +11,7 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -29,7 +30,8 @@ enum class TailField
 {
     ChunkType,
     NumPoints,
-    NumBytes
+    NumBytes,
+    Ticks
 };
 
 using TailFields = std::vector<TailField>;
@@ -39,7 +41,8 @@ const TailFieldLookup tailFieldNames
 {
     { TailField::ChunkType, "chunkType" },
     { TailField::NumPoints, "numPoints" },
-    { TailField::NumBytes, "numBytes" }
+    { TailField::NumBytes, "numBytes" },
+    { TailField::Ticks, "ticks" }
 };
 
 inline TailField tailFieldFromName(std::string name)
@@ -61,13 +64,26 @@ inline TailField tailFieldFromName(std::string name)
     return it->first;
 }
 
-enum class HierarchyCompression { None, Lzma };
+// Points within a serialized chunk are sorted by their Z-tick (see
+// Tube::calcTick) at their chunk's depth.  Each entry holds a distinct tick
+// along with the index of the first point having that tick, in ascending
+// order, so a range of ticks maps to a contiguous range of points.
+struct TickEntry
+{
+    uint64_t tick;
+    uint64_t offset;
+};
+
+using TickIndex = std::vector<TickEntry>;
+
+enum class HierarchyCompression { None, Lzma, Zstd };
 
 using HierarchyCompressionLookup = std::map<HierarchyCompression, std::string>;
 const HierarchyCompressionLookup hierarchyCompressionNames
 {
     { HierarchyCompression::None, "none" },
-    { HierarchyCompression::Lzma, "lzma" }
+    { HierarchyCompression::Lzma, "lzma" },
+    { HierarchyCompression::Zstd, "zstd" }
 };
 
 inline HierarchyCompression hierarchyCompressionFromName(std::string name)
@@ -91,5 +107,37 @@ inline HierarchyCompression hierarchyCompressionFromName(std::string name)
     return it->first;
 }
 
+// Raw blocks are fixed-width (index, tick, count) triples of uint64_t.  Varint
+// blocks group the cells of each tube and delta-encode indices and ticks.
+enum class HierarchyEncoding { Raw, Varint };
+
+using HierarchyEncodingLookup = std::map<HierarchyEncoding, std::string>;
+const HierarchyEncodingLookup hierarchyEncodingNames
+{
+    { HierarchyEncoding::Raw, "raw" },
+    { HierarchyEncoding::Varint, "varint" }
+};
+
+inline HierarchyEncoding hierarchyEncodingFromName(std::string name)
+{
+    if (name.empty()) return HierarchyEncoding::Raw;
+
+    const auto it(
+            std::find_if(
+                hierarchyEncodingNames.begin(),
+                hierarchyEncodingNames.end(),
+                [&name](const HierarchyEncodingLookup::value_type& p)
+                {
+                    return p.second == name;
+                }));
+
+    if (it == hierarchyEncodingNames.end())
+    {
+        throw std::runtime_error("Invalid hierarchy encoding name: " + name);
+    }
+
+    return it->first;
+}
+
 } // namespace entwine
 
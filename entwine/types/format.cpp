@@ -46,12 +46,18 @@ Format::Format(
         const Metadata& metadata,
         const bool trustHeaders,
         const bool compress,
+        const bool mortonOrder,
+        const bool chunkStats,
         const HierarchyCompression hierarchyCompression,
+        const HierarchyEncoding hierarchyEncoding,
         const std::vector<std::string> tailFields)
     : m_metadata(metadata)
     , m_trustHeaders(trustHeaders)
     , m_compress(compress)
+    , m_mortonOrder(mortonOrder)
+    , m_chunkStats(chunkStats)
     , m_hierarchyCompression(hierarchyCompression)
+    , m_hierarchyEncoding(hierarchyEncoding)
     , m_tailFields(std::accumulate(
                 tailFields.begin(),
                 tailFields.end(),
@@ -89,13 +95,17 @@ Format::Format(const Metadata& metadata, const Json::Value& json)
             metadata,
             json["trustHeaders"].asBool(),
             json["compress"].asBool(),
+            json["mortonOrder"].asBool(),
+            json["chunkStats"].asBool(),
             hierarchyCompressionFromName(json["compressHierarchy"].asString()),
+            hierarchyEncodingFromName(json["hierarchyEncoding"].asString()),
             fieldsFromJson(json["tail"]))
 { }
 
 std::unique_ptr<std::vector<char>> Format::pack(
         Data::PooledStack dataStack,
-        const ChunkType chunkType) const
+        const ChunkType chunkType,
+        const TickIndex* ticks) const
 {
     std::unique_ptr<std::vector<char>> data;
     const std::size_t numPoints(dataStack.size());
@@ -120,7 +130,7 @@ std::unique_ptr<std::vector<char>> Format::pack(
     assert(data);
     dataStack.reset();
 
-    Packer packer(m_tailFields, *data, numPoints, chunkType);
+    Packer packer(m_tailFields, *data, numPoints, chunkType, ticks);
     append(*data, packer.buildTail());
 
     return data;
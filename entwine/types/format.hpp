@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <set>
@@ -43,17 +44,23 @@ public:
             const Metadata& metadata,
             bool trustHeaders = true,
             bool compress = true,
+            bool mortonOrder = false,
+            bool chunkStats = false,
             HierarchyCompression hierarchyCompression =
                 HierarchyCompression::Lzma,
+            HierarchyEncoding hierarchyEncoding = HierarchyEncoding::Varint,
             std::vector<std::string> tailFields = std::vector<std::string> {
-                "numPoints", "chunkType"
+                "ticks", "numPoints", "chunkType"
             });
 
     Format(const Metadata& metadata, const Format& other)
         : m_metadata(metadata)
         , m_trustHeaders(other.trustHeaders())
         , m_compress(other.compress())
+        , m_mortonOrder(other.mortonOrder())
+        , m_chunkStats(other.chunkStats())
         , m_hierarchyCompression(other.hierarchyCompression())
+        , m_hierarchyEncoding(other.hierarchyEncoding())
         , m_tailFields(other.tailFields())
     { }
 
@@ -64,6 +71,8 @@ public:
         Json::Value json;
         json["trustHeaders"] = m_trustHeaders;
         json["compress"] = m_compress;
+        if (m_mortonOrder) json["mortonOrder"] = true;
+        if (m_chunkStats) json["chunkStats"] = true;
 
         for (const TailField f : m_tailFields)
         {
@@ -75,26 +84,50 @@ public:
                 hierarchyCompressionNames.at(m_hierarchyCompression) :
                 "none";
 
+        json["hierarchyEncoding"] =
+            hierarchyEncodingNames.at(m_hierarchyEncoding);
+
         return json;
     }
 
+    // If the tail contains a tick index, the points of the dataStack must
+    // already be sorted by tick and described by the incoming ticks.
     std::unique_ptr<std::vector<char>> pack(
             Data::PooledStack dataStack,
-            ChunkType chunkType) const;
+            ChunkType chunkType,
+            const TickIndex* ticks = nullptr) const;
 
     Unpacker unpack(std::unique_ptr<std::vector<char>> data) const
     {
         return Unpacker(*this, std::move(data));
     }
 
+    // Unpack from borrowed memory, which must outlive the returned Unpacker
+    // and anything read from its raw data.
+    Unpacker unpack(const char* data, std::size_t size) const
+    {
+        return Unpacker(*this, data, size);
+    }
+
     const TailFields& tailFields() const { return m_tailFields; }
+    bool hasTailField(TailField field) const
+    {
+        return
+            std::find(m_tailFields.begin(), m_tailFields.end(), field) !=
+            m_tailFields.end();
+    }
 
     bool trustHeaders() const { return m_trustHeaders; }
     bool compress() const { return m_compress; }
+    bool mortonOrder() const { return m_mortonOrder; }
+
+    // If true, each cold chunk has a ChunkStats sidecar.
+    bool chunkStats() const { return m_chunkStats; }
     HierarchyCompression hierarchyCompression() const
     {
         return m_hierarchyCompression;
     }
+    HierarchyEncoding hierarchyEncoding() const { return m_hierarchyEncoding; }
 
     const Metadata& metadata() const;
     const Schema& schema() const;
@@ -104,7 +137,10 @@ private:
 
     bool m_trustHeaders;
     bool m_compress;
+    bool m_mortonOrder;
+    bool m_chunkStats;
     HierarchyCompression m_hierarchyCompression;
+    HierarchyEncoding m_hierarchyEncoding;
     TailFields m_tailFields;
 };
 
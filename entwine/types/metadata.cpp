@@ -39,12 +39,15 @@ Metadata::Metadata(
         const Manifest& manifest,
         const bool trustHeaders,
         const bool compress,
+        const bool mortonOrder,
+        const bool chunkStats,
         const HierarchyCompression hierarchyCompress,
         const Reprojection* reprojection,
         const Subset* subset,
         const Delta* delta,
         const Transformation* transformation,
-        const cesium::Settings* cesiumSettings)
+        const cesium::Settings* cesiumSettings,
+        const Constants* constants)
     : m_delta(maybeClone(delta))
     , m_boundsNativeConforming(clone(boundsNativeConforming))
     , m_boundsNativeCubic(clone(makeNativeCube(boundsNativeConforming, delta)))
@@ -63,6 +66,8 @@ Metadata::Metadata(
                 *this,
                 trustHeaders,
                 compress,
+                mortonOrder,
+                chunkStats,
                 hierarchyCompress))
     , m_reprojection(maybeClone(reprojection))
     , m_subset(maybeClone(subset))
@@ -70,31 +75,42 @@ Metadata::Metadata(
     , m_cesiumSettings(maybeClone(cesiumSettings))
     , m_version(makeUnique<Version>(currentVersion()))
     , m_srs()
+    , m_constants(constants ? *constants : Constants())
     , m_errors()
 { }
 
 Metadata::Metadata(const arbiter::Endpoint& ep, const std::size_t* subsetId)
-    : Metadata(([&ep, subsetId]()
+    : Metadata(fetch(ep, subsetId))
+{
+    assert(!subsetId || *subsetId == m_subset->id());
+    m_manifest = fetchManifest(ep);
+}
+
+Json::Value Metadata::fetch(
+        const arbiter::Endpoint& ep,
+        const std::size_t* subsetId)
+{
+    // Prior to 1.0, there were some keys nested in the top-level "format"
+    // key.  Now those nested keys are themselves at the top level.
+    //
+    // Note that we are not constructed yet so we can't call our
+    // Metadata::postfix() yet, as we would like to.
+    Json::Value json(parse(ep.get("entwine" + Subset::postfix(subsetId))));
+    if (json.isMember("format"))
     {
-        // Prior to 1.0, there were some keys nested in the top-level "format"
-        // key.  Now those nested keys are themselves at the top level.
-        //
-        // Note that we are not fully-constructed yet so we can't call our
-        // Metadata::postfix() yet, as we would like to.
-        Json::Value json(parse(ep.get("entwine" + Subset::postfix(subsetId))));
-        if (json.isMember("format"))
+        for (const auto& k : json["format"].getMemberNames())
         {
-            for (const auto& k : json["format"].getMemberNames())
-            {
-                json[k] = json["format"][k];
-            }
+            json[k] = json["format"][k];
         }
-        return json;
-    })())
+    }
+    return json;
+}
+
+std::unique_ptr<Manifest> Metadata::fetchManifest(
+        const arbiter::Endpoint& ep) const
 {
-    assert(!subsetId || *subsetId == m_subset->id());
     const Json::Value json(parse(ep.get("entwine-manifest" + postfix())));
-    m_manifest = makeUnique<Manifest>(json, ep);
+    return makeUnique<Manifest>(json, ep);
 }
 
 Metadata::Metadata(const Json::Value& json)
@@ -125,8 +141,15 @@ Metadata::Metadata(const Json::Value& json)
                 nullptr)
     , m_version(makeUnique<Version>(json["version"].asString()))
     , m_srs(json["srs"].asString())
+    , m_constants()
     , m_errors(extract<std::string>(json["errors"]))
-{ }
+{
+    const Json::Value& constants(json["constants"]);
+    for (const auto& k : constants.getMemberNames())
+    {
+        m_constants.emplace(k, Constant(constants[k]));
+    }
+}
 
 Metadata::Metadata(const Metadata& other)
     : m_delta(maybeClone(other.delta()))
@@ -146,6 +169,7 @@ Metadata::Metadata(const Metadata& other)
     , m_cesiumSettings(maybeClone(other.cesiumSettings()))
     , m_version(makeUnique<Version>(other.version()))
     , m_srs(other.srs())
+    , m_constants(other.constants())
     , m_errors(other.errors())
 { }
 
@@ -173,6 +197,11 @@ Json::Value Metadata::toJson() const
         m_delta->insertInto(json);
     }
 
+    for (const auto& c : m_constants)
+    {
+        json["constants"][c.first] = c.second.toJson();
+    }
+
     if (m_transformation)
     {
         for (const double v : *m_transformation)
@@ -267,5 +296,12 @@ Bounds Metadata::makeNativeCube(
     return makeScaledCube(nativeConformingBounds, delta).undeltify(delta);
 }
 
+Bounds Metadata::makeScaledEpsilon(
+        const Bounds& nativeConformingBounds,
+        const Delta* delta)
+{
+    return nativeConformingBounds.deltify(delta).growBy(epsilon);
+}
+
 } // namespace entwine
 
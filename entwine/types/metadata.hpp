@@ -15,6 +15,8 @@
 #include <vector>
 
 #include <entwine/types/bounds.hpp>
+#include <entwine/types/constant.hpp>
+#include <entwine/types/defs.hpp>
 #include <entwine/types/format-types.hpp>
 
 namespace Json { class Value; }
@@ -38,6 +40,7 @@ class Version;
 class Metadata
 {
     friend class Builder;
+    friend class Reader;
     friend class Sequence;
 
 public:
@@ -49,12 +52,15 @@ public:
             const Manifest& manifest,
             bool trustHeaders,
             bool compress,
+            bool mortonOrder,
+            bool chunkStats,
             HierarchyCompression hierarchyCompress,
             const Reprojection* reprojection = nullptr,
             const Subset* subset = nullptr,
             const Delta* delta = nullptr,
             const std::vector<double>* transformation = nullptr,
-            const cesium::Settings* cesiumSettings = nullptr);
+            const cesium::Settings* cesiumSettings = nullptr,
+            const Constants* constants = nullptr);
 
     Metadata(
             const arbiter::Endpoint& endpoint,
@@ -76,6 +82,11 @@ public:
             const Bounds& nativeConformingBounds,
             const Delta* delta);
 
+    // Scaled bounds within which points are accepted for insertion.
+    static Bounds makeScaledEpsilon(
+            const Bounds& nativeConformingBounds,
+            const Delta* delta);
+
     // Native bounds - no scale/offset applied.
     const Bounds& boundsNativeConforming() const
     {
@@ -126,6 +137,10 @@ public:
         return m_cesiumSettings.get();
     }
 
+    // Dimensions pruned from the schema for holding a single value across
+    // the entire dataset.
+    const Constants& constants() const { return m_constants; }
+
     const Version& version() const { return *m_version; }
     const std::string& srs() const { return m_srs; }
 
@@ -139,6 +154,15 @@ public:
 private:
     Metadata& operator=(const Metadata& other);
 
+    // Our own file, and our manifest, which relies only on its contents.
+    // Fetched separately, the manifest may be overlapped with other work.
+    static Json::Value fetch(
+            const arbiter::Endpoint& endpoint,
+            const std::size_t* subsetId);
+
+    std::unique_ptr<Manifest> fetchManifest(
+            const arbiter::Endpoint& endpoint) const;
+
     // These are aggregated as the Builder runs.
     Manifest& manifest() { return *m_manifest; }
     Format& format() { return *m_format; }
@@ -165,6 +189,7 @@ private:
     std::unique_ptr<cesium::Settings> m_cesiumSettings;
     std::unique_ptr<Version> m_version;
     std::string m_srs;
+    Constants m_constants;
 
     std::vector<std::string> m_errors;
 };
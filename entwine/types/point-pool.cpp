@@ -0,0 +1,31 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#include <entwine/types/point-pool.hpp>
+
+namespace entwine
+{
+
+CellLayout::CellLayout(const Schema& schema)
+{
+    using DimId = pdal::Dimension::Id;
+    const std::array<DimId, 3> ids { { DimId::X, DimId::Y, DimId::Z } };
+    const pdal::PointLayout& layout(schema.pdalLayout());
+
+    for (std::size_t i(0); i < ids.size(); ++i)
+    {
+        const pdal::Dimension::Detail* detail(layout.dimDetail(ids[i]));
+        m_offsets[i] = detail->offset();
+        m_types[i] = detail->type();
+    }
+}
+
+} // namespace entwine
+
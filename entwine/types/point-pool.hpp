@@ -10,8 +10,12 @@
 
 #pragma once
 
+#include <array>
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <stdexcept>
 
 #include <pdal/PointRef.hpp>
 
@@ -36,6 +40,58 @@ public:
     Data() = delete;
 };
 
+// Describes where the X, Y, and Z coordinates live within a pooled point
+// record, so a Cell can decode its position from its data rather than
+// carrying a separate copy of it.  Each PointPool holds the layout of its
+// schema, to which its Cells point.
+class CellLayout
+{
+public:
+    explicit CellLayout(const Schema& schema);
+
+    Point point(const char* data) const
+    {
+        return Point(read(data, 0), read(data, 1), read(data, 2));
+    }
+
+private:
+    double read(const char* data, std::size_t i) const
+    {
+        using Type = pdal::Dimension::Type;
+        const char* pos(data + m_offsets[i]);
+
+        switch (m_types[i])
+        {
+            case Type::Double:      return as<double>(pos);
+            case Type::Float:       return as<float>(pos);
+            case Type::Signed8:     return as<int8_t>(pos);
+            case Type::Signed16:    return as<int16_t>(pos);
+            case Type::Signed32:    return as<int32_t>(pos);
+            case Type::Signed64:    return as<int64_t>(pos);
+            case Type::Unsigned8:   return as<uint8_t>(pos);
+            case Type::Unsigned16:  return as<uint16_t>(pos);
+            case Type::Unsigned32:  return as<uint32_t>(pos);
+            case Type::Unsigned64:  return as<uint64_t>(pos);
+            default: throw std::runtime_error("Invalid coordinate type");
+        }
+    }
+
+    template<typename T>
+    static double as(const char* pos)
+    {
+        T v;
+        std::memcpy(&v, pos, sizeof(T));
+        return v;
+    }
+
+    std::array<std::size_t, 3> m_offsets;
+    std::array<pdal::Dimension::Type, 3> m_types;
+};
+
+// A Cell is the build-time handle for the point records sharing a single
+// position.  Its position is decoded on demand from the head record through
+// the layout of its PointPool, rather than stored alongside.  Callers that
+// use a position repeatedly should decode it once.
 class Cell
 {
 public:
@@ -45,9 +101,9 @@ public:
     using PooledNode = Pool::UniqueNodeType;
     using PooledStack = Pool::UniqueStackType;
 
-    Cell() noexcept : m_point(), m_dataStack() { }
+    Cell() noexcept : m_dataStack(), m_layout(nullptr) { }
 
-    const Point& point() const { return m_point; }
+    Point point() const { return m_layout->point(**m_dataStack.head()); }
     Data::RawStack&& acquire() { return std::move(m_dataStack); }
 
     void push(Cell::PooledNode&& other, std::size_t pointSize)
@@ -74,19 +130,15 @@ public:
         return **m_dataStack.head();
     }
 
-    void set(const pdal::PointRef& pointRef, Data::PooledNode&& dataNode)
+    void set(Data::PooledNode&& dataNode, const CellLayout& layout)
     {
-        m_point = Point(
-                pointRef.getFieldAs<double>(pdal::Dimension::Id::X),
-                pointRef.getFieldAs<double>(pdal::Dimension::Id::Y),
-                pointRef.getFieldAs<double>(pdal::Dimension::Id::Z));
-
         m_dataStack.push(dataNode.release());
+        m_layout = &layout;
     }
 
 private:
-    Point m_point;
     Data::RawStack m_dataStack;
+    const CellLayout* m_layout;
 };
 
 class Delta;
@@ -99,12 +151,14 @@ public:
         , m_delta(delta)
         , m_dataPool(schema.pointSize(), heuristics::poolBlockSize)
         , m_cellPool(heuristics::poolBlockSize)
+        , m_cellLayout(schema)
     { }
 
     const Schema& schema() const { return m_schema; }
     const Delta* delta() const { return m_delta; }
     Data::Pool& dataPool() { return m_dataPool; }
     Cell::Pool& cellPool() { return m_cellPool; }
+    const CellLayout& cellLayout() const { return m_cellLayout; }
 
 private:
     const Schema& m_schema;
@@ -112,6 +166,7 @@ private:
 
     Data::Pool m_dataPool;
     Cell::Pool m_cellPool;
+    const CellLayout m_cellLayout;
 };
 
 } // namespace entwine
@@ -58,7 +58,7 @@ void PooledPointTable::reset()
             ++m_index;
         }
 
-        cell.set(pointRef, std::move(data));
+        cell.set(std::move(data), m_pointPool.cellLayout());
     }
 
     cells = m_process(std::move(cells));
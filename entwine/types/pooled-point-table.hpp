@@ -12,6 +12,10 @@
 
 #include <array>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 
 #include <pdal/Dimension.hpp>
 #include <pdal/PointTable.hpp>
@@ -162,15 +166,26 @@ protected:
         }
     }
 
+    // Values beyond the range of T saturate rather than wrapping around.
+    // Schema::deltify leaves headroom past our insertion bounds at both ends
+    // of each type, so saturated points fall outside of those bounds and are
+    // rejected as out of bounds.
     template<typename T>
-    void setConverted(T value, char* dst)
+    static void setConverted(double value, char* dst)
     {
-        *reinterpret_cast<T*>(dst) = value;
+        using Limits = std::numeric_limits<T>;
+        T v(0);
+
+        if (!(value > Limits::min())) v = Limits::min();
+        else if (value >= static_cast<double>(Limits::max())) v = Limits::max();
+        else v = static_cast<T>(std::llround(value));
+
+        std::memcpy(dst, &v, sizeof(T));
     }
 
     virtual void reset() override
     {
-        int64_t v(0);
+        double v(0);
         for (std::size_t i(0); i < outstanding(); ++i)
         {
             const Point& p(m_points[i]);
@@ -178,23 +193,20 @@ protected:
 
             for (std::size_t dim(0); dim < 3; ++dim)
             {
-                v = std::llround(
-                        Point::scale(
-                            p[dim],
-                            m_delta.scale()[dim],
-                            m_delta.offset()[dim]));
+                v = Point::scale(
+                        p[dim],
+                        m_delta.scale()[dim],
+                        m_delta.offset()[dim]);
 
-                if (m_sizes[dim] == 4)
-                {
-                    *reinterpret_cast<int32_t*>(dst + m_offsets[dim]) = v;
-                }
-                else if (m_sizes[dim] == 8)
-                {
-                    *reinterpret_cast<int64_t*>(dst + m_offsets[dim]) = v;
-                }
-                else
+                char* pos(dst + m_offsets[dim]);
+
+                switch (m_sizes[dim])
                 {
-                    throw std::runtime_error("Invalid XYZ size");
+                    case 1: setConverted<int8_t>(v, pos); break;
+                    case 2: setConverted<int16_t>(v, pos); break;
+                    case 4: setConverted<int32_t>(v, pos); break;
+                    case 8: setConverted<int64_t>(v, pos); break;
+                    default: throw std::runtime_error("Invalid XYZ size");
                 }
             }
         }
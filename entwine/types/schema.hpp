@@ -10,7 +10,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <iostream>
 #include <limits>
 #include <memory>
 #include <numeric>
@@ -172,41 +176,55 @@ public:
         return Schema(dims);
     };
 
+    // Each of X, Y, and Z is stored as the narrowest signed integer type
+    // that holds every scaled value within the given bounds, which must
+    // contain all points to be stored.
     static Schema deltify(
-            const Bounds& scaledCube,
+            const Bounds& scaledBounds,
             const Delta& delta,
             const Schema& inSchema)
     {
-        pdal::Dimension::Type spatialType(pdal::Dimension::Type::Double);
+        auto spatialType([&scaledBounds](std::size_t dim)
+        {
+            const double extent(
+                    std::max(
+                        std::abs(std::floor(scaledBounds.min()[dim])),
+                        std::abs(std::ceil(scaledBounds.max()[dim]))) + 1);
 
-        const Point ticks(
-                scaledCube.width(),
-                scaledCube.depth(),
-                scaledCube.height());
+            // Strictly less, so that the extremes of the chosen type lie
+            // outside of scaledBounds.  Out-of-range points saturate to
+            // them on insertion, and are then rejected as out of bounds.
+            auto fits([extent](double max) { return extent < max; });
 
-        auto fitsWithin([&ticks](double max)
-        {
-            return ticks.x < max && ticks.y < max && ticks.z < max;
+            if (fits(std::numeric_limits<int8_t>::max()))
+            {
+                return pdal::Dimension::Type::Signed8;
+            }
+            else if (fits(std::numeric_limits<int16_t>::max()))
+            {
+                return pdal::Dimension::Type::Signed16;
+            }
+            else if (fits(std::numeric_limits<int32_t>::max()))
+            {
+                return pdal::Dimension::Type::Signed32;
+            }
+            else if (fits(std::numeric_limits<int64_t>::max()))
+            {
+                return pdal::Dimension::Type::Signed64;
+            }
+            else
+            {
+                std::cout << "Cannot use this scale for these bounds" <<
+                    std::endl;
+                return pdal::Dimension::Type::Double;
+            }
         });
 
-        if (fitsWithin(std::numeric_limits<uint32_t>::max()))
-        {
-            spatialType = pdal::Dimension::Type::Signed32;
-        }
-        else if (fitsWithin(std::numeric_limits<uint64_t>::max()))
-        {
-            spatialType = pdal::Dimension::Type::Signed64;
-        }
-        else
-        {
-            std::cout << "Cannot use this scale for these bounds" << std::endl;
-        }
-
         DimList dims
         {
-            DimInfo(pdal::Dimension::Id::X, spatialType),
-            DimInfo(pdal::Dimension::Id::Y, spatialType),
-            DimInfo(pdal::Dimension::Id::Z, spatialType)
+            DimInfo(pdal::Dimension::Id::X, spatialType(0)),
+            DimInfo(pdal::Dimension::Id::Y, spatialType(1)),
+            DimInfo(pdal::Dimension::Id::Z, spatialType(2))
         };
 
         for (const auto& dim : inSchema.dims())
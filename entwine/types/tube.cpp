@@ -26,14 +26,17 @@ Tube::Insertion Tube::insert(const Climber& climber, Cell::PooledNode& cell)
     {
         Cell::PooledNode& curr(it->second);
 
-        if (cell->point() != curr->point())
+        const Point incoming(cell->point());
+        const Point existing(curr->point());
+
+        if (incoming != existing)
         {
             const Point& center(climber.bounds().mid());
 
-            const auto a(cell->point().sqDist3d(center));
-            const auto b(curr->point().sqDist3d(center));
+            const auto a(incoming.sqDist3d(center));
+            const auto b(existing.sqDist3d(center));
 
-            if (a < b || (a == b && ltChained(cell->point(), curr->point())))
+            if (a < b || (a == b && ltChained(incoming, existing)))
             {
                 // We are inserting cell, and extracting curr.  Store our new
                 // cell, and send the previous one further down the tree.
@@ -31,12 +31,10 @@ std::unique_ptr<std::vector<char>> Compression::compress(
         const Schema& schema)
 {
     CompressionStream compressionStream(size);
-    pdal::LazPerfCompressor<CompressionStream> compressor(
-            compressionStream,
-            schema.pdalLayout().dimTypes());
+    auto encoder(PointEncoder::create(compressionStream, schema));
 
-    compressor.compress(data, size);
-    compressor.done();
+    encoder->compress(data, size);
+    encoder->done();
 
     return compressionStream.data();
 }
@@ -49,14 +47,12 @@ std::unique_ptr<std::vector<char>> Compression::decompress(
     const std::size_t decompressedSize(numPoints * schema.pointSize());
 
     DecompressionStream decompressionStream(data);
-    pdal::LazPerfDecompressor<DecompressionStream> decompressor(
-            decompressionStream,
-            schema.pdalLayout().dimTypes());
+    auto decoder(PointDecoder::create(decompressionStream, schema));
 
     std::unique_ptr<std::vector<char>> decompressed(
             new std::vector<char>(decompressedSize));
 
-    decompressor.decompress(decompressed->data(), decompressed->size());
+    decoder->decompress(decompressed->data(), decompressed->size());
 
     return decompressed;
 }
@@ -72,11 +68,9 @@ std::unique_ptr<std::vector<char>> Compression::decompress(
         return decompress(data, nativeSchema, numPoints);
     }
 
-    // Get decompressor in the native schema.
+    // Get a decoder in the native schema.
     DecompressionStream decompressionStream(data);
-    pdal::LazPerfDecompressor<DecompressionStream> decompressor(
-            decompressionStream,
-            nativeSchema.pdalLayout().dimTypes());
+    auto decoder(PointDecoder::create(decompressionStream, nativeSchema));
 
     // Allocate room for a single point in the native schema.
     std::vector<char> nativePoint(nativeSchema.pointSize());
@@ -91,7 +85,7 @@ std::unique_ptr<std::vector<char>> Compression::decompress(
 
     while (pos < end)
     {
-        decompressor.decompress(nativePoint.data(), nativePoint.size());
+        decoder->decompress(nativePoint.data(), nativePoint.size());
 
         for (const auto& d : wantedSchema->dims())
         {
@@ -111,24 +105,18 @@ Cell::PooledStack Compression::decompress(
     Data::PooledStack dataStack(pointPool.dataPool().acquire(numPoints));
     Cell::PooledStack cellStack(pointPool.cellPool().acquire(numPoints));
 
-    BinaryPointTable table(pointPool.schema());
-    pdal::PointRef pointRef(table, 0);
-
     const std::size_t pointSize(pointPool.schema().pointSize());
 
     DecompressionStream decompressionStream(data);
-    pdal::LazPerfDecompressor<DecompressionStream> decompressor(
-            decompressionStream,
-            pointPool.schema().pdalLayout().dimTypes());
+    auto decoder(PointDecoder::create(decompressionStream, pointPool.schema()));
 
     for (Cell& cell : cellStack)
     {
         Data::PooledNode dataNode(dataStack.popOne());
 
-        decompressor.decompress(*dataNode, pointSize);
+        decoder->decompress(*dataNode, pointSize);
 
-        table.setPoint(*dataNode);
-        cell.set(pointRef, std::move(dataNode));
+        cell.set(std::move(dataNode), pointPool.cellLayout());
     }
 
     return cellStack;
@@ -138,17 +126,17 @@ Cell::PooledStack Compression::decompress(
 
 Compressor::Compressor(const Schema& schema, std::size_t numPoints)
     : m_stream(schema.pointSize() * numPoints)
-    , m_compressor(m_stream, schema.pdalLayout().dimTypes())
+    , m_encoder(PointEncoder::create(m_stream, schema))
 { }
 
 void Compressor::push(const char* data, const std::size_t size)
 {
-    m_compressor.compress(data, size);
+    m_encoder->compress(data, size);
 }
 
 std::unique_ptr<std::vector<char>> Compressor::data()
 {
-    m_compressor.done();
+    m_encoder->done();
     return m_stream.data();
 }
 
@@ -20,6 +20,7 @@
 #include <pdal/Compression.hpp>
 
 #include <entwine/types/structure.hpp>
+#include <entwine/util/point-codec.hpp>
 
 namespace entwine
 {
@@ -123,6 +124,13 @@ public:
     static std::unique_ptr<std::vector<char>> decompressLzma(
             const std::vector<char>& data);
 
+    // These throw if Entwine was built without zstd.
+    static std::unique_ptr<std::vector<char>> compressZstd(
+            const std::vector<char>& data);
+
+    static std::unique_ptr<std::vector<char>> decompressZstd(
+            const std::vector<char>& data);
+
     Compression() = delete;
 };
 
@@ -142,7 +150,7 @@ public:
 
 private:
     CompressionStream m_stream;
-    pdal::LazPerfCompressor<CompressionStream> m_compressor;
+    std::unique_ptr<PointEncoder> m_encoder;
 };
 
 } // namespace entwine
@@ -0,0 +1,125 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#include <entwine/util/fair-semaphore.hpp>
+
+#include <stdexcept>
+
+namespace entwine
+{
+
+FairSemaphore::FairSemaphore(const std::size_t capacity)
+    : m_capacity(capacity)
+    , m_used(0)
+    , m_waiters()
+    , m_mutex()
+{ }
+
+FairSemaphore::~FairSemaphore()
+{
+    const auto error(
+            std::make_exception_ptr(
+                std::runtime_error("Semaphore destroyed while waiting")));
+
+    for (Waiter* waiter : m_waiters)
+    {
+        if (waiter->callback)
+        {
+            waiter->callback(error);
+            delete waiter;
+        }
+    }
+}
+
+void FairSemaphore::acquire(const std::size_t n)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_waiters.empty() && fits(n))
+    {
+        m_used += n;
+        return;
+    }
+
+    Waiter waiter(n);
+    m_waiters.push_back(&waiter);
+    waiter.cv.wait(lock, [&waiter]() { return waiter.granted; });
+}
+
+void FairSemaphore::acquire(const std::size_t n, const Granted granted)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_waiters.empty() && fits(n))
+    {
+        m_used += n;
+        lock.unlock();
+
+        granted(std::exception_ptr());
+        return;
+    }
+
+    m_waiters.push_back(new Waiter(n, granted));
+}
+
+void FairSemaphore::release(const std::size_t n)
+{
+    Callbacks ready;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_used -= n;
+    grant(ready);
+    lock.unlock();
+
+    for (const auto& f : ready) f(std::exception_ptr());
+}
+
+void FairSemaphore::adjust(const std::size_t held, const std::size_t now)
+{
+    Callbacks ready;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_used = m_used - held + now;
+    if (now < held) grant(ready);
+    lock.unlock();
+
+    for (const auto& f : ready) f(std::exception_ptr());
+}
+
+std::size_t FairSemaphore::used() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_used;
+}
+
+void FairSemaphore::grant(Callbacks& ready)
+{
+    while (!m_waiters.empty() && fits(m_waiters.front()->n))
+    {
+        Waiter* waiter(m_waiters.front());
+        m_waiters.pop_front();
+
+        m_used += waiter->n;
+
+        if (waiter->callback)
+        {
+            ready.push_back(waiter->callback);
+            delete waiter;
+        }
+        else
+        {
+            waiter->granted = true;
+            waiter->cv.notify_one();
+        }
+    }
+}
+
+} // namespace entwine
+
@@ -0,0 +1,98 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace entwine
+{
+
+// A counting semaphore that grants requests in arrival order.  Each waiter
+// sleeps on its own condition variable, so a release only wakes the waiters
+// it can actually satisfy.  A request larger than the capacity is granted
+// once nothing else is held, rather than blocking forever.  Requests may also
+// be made without blocking, in which case a callback is run once granted.
+class FairSemaphore
+{
+public:
+    explicit FairSemaphore(std::size_t capacity);
+
+    // Non-blocking waiters still queued are called with an error.
+    ~FairSemaphore();
+
+    // Block until n units are granted to the caller.
+    void acquire(std::size_t n);
+
+    using Granted = std::function<void(std::exception_ptr)>;
+
+    // Queue for n units without blocking.  If they're available, granted is
+    // called immediately, otherwise it is called by the thread whose release
+    // makes them available, so it should be brief.  The error passed to it is
+    // null unless we were destroyed before the units could be granted.
+    void acquire(std::size_t n, Granted granted);
+
+    // Return n previously acquired units.
+    void release(std::size_t n);
+
+    // Change a holding of held units to now units without waiting, which may
+    // exceed the capacity.
+    void adjust(std::size_t held, std::size_t now);
+
+    std::size_t used() const;
+    std::size_t capacity() const { return m_capacity; }
+
+private:
+    struct Waiter
+    {
+        explicit Waiter(std::size_t n, Granted callback = nullptr)
+            : n(n)
+            , granted(false)
+            , cv()
+            , callback(callback)
+        { }
+
+        const std::size_t n;
+        bool granted;
+        std::condition_variable cv;
+
+        // Set for non-blocking waiters, which we own.
+        Granted callback;
+    };
+
+    using Callbacks = std::vector<Granted>;
+
+    bool fits(std::size_t n) const
+    {
+        return !m_used || m_used + n <= m_capacity;
+    }
+
+    // Grant waiters from the front of the queue while they fit.  The caller
+    // must hold m_mutex, and run the callbacks of the granted non-blocking
+    // waiters, which are appended to ready, after releasing it.
+    void grant(Callbacks& ready);
+
+    const std::size_t m_capacity;
+    std::size_t m_used;
+    std::deque<Waiter*> m_waiters;
+    mutable std::mutex m_mutex;
+
+    FairSemaphore(const FairSemaphore&) = delete;
+    FairSemaphore& operator=(const FairSemaphore&) = delete;
+};
+
+} // namespace entwine
+
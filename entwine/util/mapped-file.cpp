@@ -0,0 +1,59 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#include <entwine/util/mapped-file.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace entwine
+{
+
+MappedFile::MappedFile(const char* data, const std::size_t size)
+    : m_data(data)
+    , m_size(size)
+{ }
+
+MappedFile::~MappedFile()
+{
+    munmap(const_cast<char*>(m_data), m_size);
+}
+
+std::unique_ptr<MappedFile> MappedFile::tryMap(const std::string& path)
+{
+    std::unique_ptr<MappedFile> result;
+
+    const int fd(open(path.c_str(), O_RDONLY));
+    if (fd == -1) return result;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        const std::size_t size(info.st_size);
+        void* addr(mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0));
+
+        if (addr != MAP_FAILED)
+        {
+            // Chunks are scanned front to back when indexed, and then
+            // accessed randomly by query bounds.
+            madvise(addr, size, MADV_WILLNEED);
+            result.reset(new MappedFile(static_cast<const char*>(addr), size));
+        }
+    }
+
+    // The mapping remains valid after the descriptor is closed.
+    close(fd);
+    return result;
+}
+
+} // namespace entwine
+
@@ -0,0 +1,46 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace entwine
+{
+
+// A read-only memory mapping of an entire local file.  The mapped bytes are
+// owned by the kernel page cache rather than the process heap, so holding a
+// MappedFile open costs address space but no resident allocation of our own.
+class MappedFile
+{
+public:
+    ~MappedFile();
+
+    // Returns null if the file does not exist or cannot be mapped, in which
+    // case the caller should fall back to a normal read.
+    static std::unique_ptr<MappedFile> tryMap(const std::string& path);
+
+    const char* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+private:
+    MappedFile(const char* data, std::size_t size);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* const m_data;
+    const std::size_t m_size;
+};
+
+} // namespace entwine
+
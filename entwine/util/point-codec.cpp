@@ -0,0 +1,212 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#include <entwine/util/point-codec.hpp>
+
+#include <pdal/PointLayout.hpp>
+
+#include <entwine/types/schema.hpp>
+#include <entwine/util/compression.hpp>
+#include <entwine/util/unique.hpp>
+
+namespace entwine
+{
+
+namespace
+{
+    using namespace codec;
+
+    using Encoder = laszip::encoders::arithmetic<CompressionStream>;
+    using Decoder = laszip::decoders::arithmetic<DecompressionStream>;
+
+    using I16 = Dims<DimType::Signed16>;
+    using I32 = Dims<DimType::Signed32>;
+    using U8 = Dims<DimType::Unsigned8>;
+    using U16 = Dims<DimType::Unsigned16>;
+    using U32 = Dims<DimType::Unsigned32>;
+    using F32 = Dims<DimType::Float>;
+    using F64 = Dims<DimType::Double>;
+
+    // Spatial dimensions: scaled with a shallow Z extent, scaled, or absolute.
+    using XyzShallow = Join<I32, I32, I16>::type;
+    using XyzScaled = Join<I32, I32, I32>::type;
+    using XyzAbsolute = Join<F64, F64, F64>::type;
+
+    // Intensity, ReturnNumber, NumberOfReturns, ScanDirectionFlag,
+    // EdgeOfFlightLine, Classification, ScanAngleRank, UserData, and
+    // PointSourceId, in the order they are reported by the LAS reader.
+    using LasBase = Join<U16, U8, U8, U8, U8, U8, F32, U8, U16>::type;
+    using Rgb = Join<U16, U16, U16>::type;
+    using Extended = Join<U8, U8>::type;    // ScanChannel, ClassFlags.
+    using Ids = Join<U32, U32>::type;       // OriginId, PointId.
+
+    using Pdrf1 = Join<LasBase, F64>::type;
+    using Pdrf3 = Join<LasBase, F64, Rgb>::type;
+    using Pdrf6 = Join<LasBase, F64, Extended>::type;
+    using Pdrf7 = Join<LasBase, F64, Rgb, Extended>::type;
+
+    template<typename Xyz, typename Pdrf>
+    using Las = Record<typename Join<Xyz, Pdrf, Ids>::type>;
+
+    template<typename R>
+    class RecordEncoder : public PointEncoder
+    {
+    public:
+        RecordEncoder(CompressionStream& stream, std::size_t pointSize)
+            : m_encoder(stream)
+            , m_record()
+            , m_pointSize(pointSize)
+        { }
+
+        virtual void compress(const char* data, std::size_t size) override
+        {
+            const char* end(data + size / m_pointSize * m_pointSize);
+            while (data < end) data = m_record.compress(m_encoder, data);
+        }
+
+        virtual void done() override { m_encoder.done(); }
+
+    private:
+        Encoder m_encoder;
+        R m_record;
+        const std::size_t m_pointSize;
+    };
+
+    template<typename R>
+    class RecordDecoder : public PointDecoder
+    {
+    public:
+        RecordDecoder(DecompressionStream& stream, std::size_t pointSize)
+            : m_decoder(stream)
+            , m_record()
+            , m_pointSize(pointSize)
+        { }
+
+        virtual void decompress(char* data, std::size_t size) override
+        {
+            char* end(data + size / m_pointSize * m_pointSize);
+            while (data < end) data = m_record.decompress(m_decoder, data);
+        }
+
+    private:
+        Decoder m_decoder;
+        R m_record;
+        const std::size_t m_pointSize;
+    };
+
+    class GenericEncoder : public PointEncoder
+    {
+    public:
+        GenericEncoder(CompressionStream& stream, const Schema& schema)
+            : m_compressor(stream, schema.pdalLayout().dimTypes())
+        { }
+
+        virtual void compress(const char* data, std::size_t size) override
+        {
+            m_compressor.compress(data, size);
+        }
+
+        virtual void done() override { m_compressor.done(); }
+
+    private:
+        pdal::LazPerfCompressor<CompressionStream> m_compressor;
+    };
+
+    class GenericDecoder : public PointDecoder
+    {
+    public:
+        GenericDecoder(DecompressionStream& stream, const Schema& schema)
+            : m_decompressor(stream, schema.pdalLayout().dimTypes())
+        { }
+
+        virtual void decompress(char* data, std::size_t size) override
+        {
+            m_decompressor.decompress(data, size);
+        }
+
+    private:
+        pdal::LazPerfDecompressor<DecompressionStream> m_decompressor;
+    };
+
+    template<template<typename> class Coder, typename Base, typename Stream>
+    std::unique_ptr<Base> tryCreate(
+            Stream&,
+            const pdal::DimTypeList&,
+            std::size_t)
+    {
+        return std::unique_ptr<Base>();
+    }
+
+    template<
+        template<typename> class Coder,
+        typename Base,
+        typename Stream,
+        typename R,
+        typename... Rs>
+    std::unique_ptr<Base> tryCreate(
+            Stream& stream,
+            const pdal::DimTypeList& types,
+            const std::size_t pointSize)
+    {
+        if (R::matches(types)) return makeUnique<Coder<R>>(stream, pointSize);
+        return tryCreate<Coder, Base, Stream, Rs...>(stream, types, pointSize);
+    }
+
+    template<template<typename> class Coder, typename Base, typename Stream>
+    std::unique_ptr<Base> createSpecialized(
+            Stream& stream,
+            const Schema& schema)
+    {
+        return tryCreate<
+            Coder, Base, Stream,
+            Las<XyzScaled, Pdrf1>,
+            Las<XyzScaled, Pdrf3>,
+            Las<XyzScaled, Pdrf6>,
+            Las<XyzScaled, Pdrf7>,
+            Las<XyzShallow, Pdrf1>,
+            Las<XyzShallow, Pdrf3>,
+            Las<XyzShallow, Pdrf6>,
+            Las<XyzShallow, Pdrf7>,
+            Las<XyzAbsolute, Pdrf1>,
+            Las<XyzAbsolute, Pdrf3>,
+            Las<XyzAbsolute, Pdrf6>,
+            Las<XyzAbsolute, Pdrf7>>(
+                    stream,
+                    schema.pdalLayout().dimTypes(),
+                    schema.pointSize());
+    }
+}
+
+std::unique_ptr<PointEncoder> PointEncoder::create(
+        CompressionStream& stream,
+        const Schema& schema)
+{
+    if (auto e = createSpecialized<RecordEncoder, PointEncoder>(stream, schema))
+    {
+        return e;
+    }
+
+    return makeUnique<GenericEncoder>(stream, schema);
+}
+
+std::unique_ptr<PointDecoder> PointDecoder::create(
+        DecompressionStream& stream,
+        const Schema& schema)
+{
+    if (auto d = createSpecialized<RecordDecoder, PointDecoder>(stream, schema))
+    {
+        return d;
+    }
+
+    return makeUnique<GenericDecoder>(stream, schema);
+}
+
+} // namespace entwine
+
@@ -0,0 +1,192 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include <pdal/Compression.hpp>
+#include <pdal/Dimension.hpp>
+
+namespace entwine
+{
+
+class CompressionStream;
+class DecompressionStream;
+class Schema;
+
+// Point-level LazPerf coding.  The generic coders drive PDAL's dynamic field
+// compressor, which walks a runtime list of field encoders for every point.
+// For the schemas we see most often - LAS point formats 1, 3, 6, and 7 with
+// our OriginId and PointId appended - the field list is instead fixed at
+// compile time, and the matching coder is selected by the Schema's
+// dimension types.  Both paths produce identical streams.
+class PointEncoder
+{
+public:
+    virtual ~PointEncoder() { }
+
+    virtual void compress(const char* data, std::size_t size) = 0;
+    virtual void done() = 0;
+
+    static std::unique_ptr<PointEncoder> create(
+            CompressionStream& stream,
+            const Schema& schema);
+};
+
+class PointDecoder
+{
+public:
+    virtual ~PointDecoder() { }
+
+    virtual void decompress(char* data, std::size_t size) = 0;
+
+    static std::unique_ptr<PointDecoder> create(
+            DecompressionStream& stream,
+            const Schema& schema);
+};
+
+namespace codec
+{
+
+using DimType = pdal::Dimension::Type;
+
+template<DimType... Ts> struct Dims { };
+
+template<typename... Lists> struct Join;
+
+template<DimType... A>
+struct Join<Dims<A...>>
+{
+    using type = Dims<A...>;
+};
+
+template<DimType... A, DimType... B, typename... Rest>
+struct Join<Dims<A...>, Dims<B...>, Rest...>
+{
+    using type = typename Join<Dims<A..., B...>, Rest...>::type;
+};
+
+// A single LazPerf field of storage type T.
+template<typename T>
+class Field
+{
+public:
+    template<typename Encoder>
+    const char* compress(Encoder& encoder, const char* pos)
+    {
+        T v;
+        std::memcpy(&v, pos, sizeof(T));
+        m_field.compressWith(encoder, v);
+        return pos + sizeof(T);
+    }
+
+    template<typename Decoder>
+    char* decompress(Decoder& decoder, char* pos)
+    {
+        const T v(m_field.decompressWith(decoder));
+        std::memcpy(pos, &v, sizeof(T));
+        return pos + sizeof(T);
+    }
+
+private:
+    laszip::formats::field<T> m_field;
+};
+
+// Wider types are coded as two consecutive 32-bit fields.
+template<typename T>
+class FieldPair
+{
+public:
+    template<typename Encoder>
+    const char* compress(Encoder& encoder, const char* pos)
+    {
+        return m_b.compress(encoder, m_a.compress(encoder, pos));
+    }
+
+    template<typename Decoder>
+    char* decompress(Decoder& decoder, char* pos)
+    {
+        return m_b.decompress(decoder, m_a.decompress(decoder, pos));
+    }
+
+private:
+    Field<T> m_a;
+    Field<T> m_b;
+};
+
+// The mapping from PDAL dimension types to LazPerf fields must match that of
+// pdal::LazPerfCompressor so that both paths remain interchangeable.
+template<DimType T> struct Storage;
+template<> struct Storage<DimType::Signed8> : Field<int8_t> { };
+template<> struct Storage<DimType::Signed16> : Field<int16_t> { };
+template<> struct Storage<DimType::Signed32> : Field<int32_t> { };
+template<> struct Storage<DimType::Signed64> : FieldPair<int32_t> { };
+template<> struct Storage<DimType::Unsigned8> : Field<uint8_t> { };
+template<> struct Storage<DimType::Unsigned16> : Field<uint16_t> { };
+template<> struct Storage<DimType::Unsigned32> : Field<uint32_t> { };
+template<> struct Storage<DimType::Unsigned64> : FieldPair<uint32_t> { };
+template<> struct Storage<DimType::Float> : Field<int32_t> { };
+template<> struct Storage<DimType::Double> : FieldPair<int32_t> { };
+
+template<typename D> class Record;
+
+template<>
+class Record<Dims<>>
+{
+public:
+    static bool matches(const pdal::DimTypeList& types, std::size_t i)
+    {
+        return i == types.size();
+    }
+
+    template<typename Encoder>
+    const char* compress(Encoder&, const char* pos) { return pos; }
+
+    template<typename Decoder>
+    char* decompress(Decoder&, char* pos) { return pos; }
+};
+
+template<DimType T, DimType... Ts>
+class Record<Dims<T, Ts...>>
+{
+public:
+    static bool matches(const pdal::DimTypeList& types, std::size_t i = 0)
+    {
+        return
+            i < types.size() &&
+            types[i].m_type == T &&
+            Record<Dims<Ts...>>::matches(types, i + 1);
+    }
+
+    template<typename Encoder>
+    const char* compress(Encoder& encoder, const char* pos)
+    {
+        return m_next.compress(encoder, m_storage.compress(encoder, pos));
+    }
+
+    template<typename Decoder>
+    char* decompress(Decoder& decoder, char* pos)
+    {
+        return m_next.decompress(decoder, m_storage.decompress(decoder, pos));
+    }
+
+private:
+    Storage<T> m_storage;
+    Record<Dims<Ts...>> m_next;
+};
+
+} // namespace codec
+
+} // namespace entwine
+
@@ -16,6 +16,12 @@
 namespace entwine
 {
 
+namespace
+{
+    // The Pool whose worker is the current thread, if any.
+    thread_local const Pool* currentPool(nullptr);
+}
+
 Pool::Pool(const std::size_t numThreads, const std::size_t queueSize)
     : m_numThreads(std::max<std::size_t>(numThreads, 1))
     , m_queueSize(std::max<std::size_t>(queueSize, 1))
@@ -105,8 +111,34 @@ void Pool::add(std::function<void()> task)
     m_consumeCv.notify_all();
 }
 
+void Pool::post(std::function<void()> task)
+{
+    if (stop())
+    {
+        throw std::runtime_error("Attempted to post a task to a stopped Pool");
+    }
+
+    if (!numThreads())
+    {
+        throw std::runtime_error("Attempted to post a task to an empty Pool");
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_tasks.emplace(task);
+    lock.unlock();
+
+    m_consumeCv.notify_all();
+}
+
+bool Pool::onWorker() const
+{
+    return currentPool == this;
+}
+
 void Pool::work()
 {
+    currentPool = this;
+
     std::unique_lock<std::mutex> lock(m_mutex);
 
     while (!stop() || !m_tasks.empty())
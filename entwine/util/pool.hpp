@@ -56,8 +56,17 @@ public:
     // called, add() may not be called again until go() is called and completes.
     void add(std::function<void()> task);
 
+    // Add a threaded task without waiting, regardless of our queue size.
+    // Suitable for continuations posted from threads that must not block,
+    // including our own workers.
+    void post(std::function<void()> task);
+
     std::size_t numThreads() const { return m_numThreads; }
 
+    // True if called from within one of our own tasks.  Such a caller must
+    // not block on other tasks of ours, which may be queued behind it.
+    bool onWorker() const;
+
 private:
     // Worker thread function.  Wait for a task and run it - or if stop() is
     // called, complete any outstanding task and return.
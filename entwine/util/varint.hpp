@@ -0,0 +1,57 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace entwine
+{
+
+// Unsigned LEB128: seven bits per byte, least significant group first, with
+// the high bit set on every byte but the last.
+inline void pushVarint(std::vector<char>& data, uint64_t val)
+{
+    while (val >= 0x80)
+    {
+        data.push_back(static_cast<char>((val & 0x7F) | 0x80));
+        val >>= 7;
+    }
+
+    data.push_back(static_cast<char>(val));
+}
+
+inline uint64_t extractVarint(const char*& pos, const char* end)
+{
+    uint64_t val(0);
+    std::size_t shift(0);
+    uint8_t byte(0);
+
+    do
+    {
+        if (pos == end || shift > 63)
+        {
+            throw std::runtime_error("Invalid varint");
+        }
+
+        byte = static_cast<uint8_t>(*pos++);
+        val |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        shift += 7;
+    }
+    while (byte & 0x80);
+
+    return val;
+}
+
+} // namespace entwine
+
@@ -0,0 +1,131 @@
+/******************************************************************************
+* Copyright (c) 2016, Connor Manning (connor@hobu.co)
+*
+* Entwine -- Point cloud indexing
+*
+* Entwine is available under the terms of the LGPL2 license. See COPYING
+* for specific license text and more information.
+*
+******************************************************************************/
+
+#include <entwine/util/compression.hpp>
+
+#ifdef ENTWINE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <entwine/util/unique.hpp>
+
+namespace entwine
+{
+
+#ifdef ENTWINE_ZSTD
+
+namespace
+{
+
+// Hierarchy blocks are small and written once, so favor decode speed and a
+// cheap encode over ratio.
+const int level(3);
+
+void check(std::size_t code)
+{
+    if (ZSTD_isError(code))
+    {
+        throw std::runtime_error(
+                std::string("Zstd error: ") + ZSTD_getErrorName(code));
+    }
+}
+
+} // unnamed namespace
+
+std::unique_ptr<std::vector<char>> Compression::compressZstd(
+        const std::vector<char>& in)
+{
+    auto out(makeUnique<std::vector<char>>(ZSTD_compressBound(in.size())));
+
+    const std::size_t size(
+            ZSTD_compress(
+                out->data(),
+                out->size(),
+                in.data(),
+                in.size(),
+                level));
+
+    check(size);
+    out->resize(size);
+
+    // Append compressed size to guard against partial downloads.
+    const uint64_t outSize(out->size());
+    out->insert(
+            out->end(),
+            reinterpret_cast<const char*>(&outSize),
+            reinterpret_cast<const char*>(&outSize) + sizeof(uint64_t));
+
+    return out;
+}
+
+std::unique_ptr<std::vector<char>> Compression::decompressZstd(
+        const std::vector<char>& in)
+{
+    if (in.size() < sizeof(uint64_t))
+    {
+        throw std::runtime_error("Invalid zstd data");
+    }
+
+    const std::size_t compressedSize(in.size() - sizeof(uint64_t));
+
+    uint64_t marker(0);
+    std::copy(
+            in.data() + compressedSize,
+            in.data() + in.size(),
+            reinterpret_cast<char*>(&marker));
+
+    if (marker != compressedSize)
+    {
+        throw std::runtime_error("Possible zstd partial download detected");
+    }
+
+    const unsigned long long rawSize(
+            ZSTD_getFrameContentSize(in.data(), compressedSize));
+
+    if (
+            rawSize == ZSTD_CONTENTSIZE_ERROR ||
+            rawSize == ZSTD_CONTENTSIZE_UNKNOWN)
+    {
+        throw std::runtime_error("Invalid zstd frame");
+    }
+
+    auto out(makeUnique<std::vector<char>>(rawSize));
+
+    const std::size_t size(
+            ZSTD_decompress(
+                out->data(),
+                out->size(),
+                in.data(),
+                compressedSize));
+
+    check(size);
+    out->resize(size);
+
+    return out;
+}
+
+#else
+
+std::unique_ptr<std::vector<char>> Compression::compressZstd(
+        const std::vector<char>& in)
+{
+    throw std::runtime_error("Entwine was not built with zstd support");
+}
+
+std::unique_ptr<std::vector<char>> Compression::decompressZstd(
+        const std::vector<char>& in)
+{
+    throw std::runtime_error("Entwine was not built with zstd support");
+}
+
+#endif
+
+} // namespace entwine
+
@@ -117,6 +117,11 @@ namespace
             "\t-c\n"
             "\t\tIf set, compression will be disabled.\n\n"
 
+            "\t-d\n"
+            "\t\tIf set, inference will scan every file and drop dimensions\n"
+            "\t\tholding a single value across the whole dataset.  These\n"
+            "\t\tare recorded as constants and synthesized on output.\n\n"
+
             "\t-n\n"
             "\t\tIf set, absolute positioning will be used, even if values\n"
             "\t\tfor scale/offset can be inferred.\n\n"
@@ -311,6 +316,7 @@ void Kernel::build(std::vector<std::string> args)
         else if (arg == "-x") { json["trustHeaders"] = false; }
         else if (arg == "-p") { json["prefixIds"] = true; }
         else if (arg == "-c") { json["compress"] = false; }
+        else if (arg == "-d") { json["pruneConstants"] = true; }
         else if (arg == "-n") { json["absolute"] = true; }
         else if (arg == "-e") { arbiterConfig["s3"]["sse"] = true; }
         else if (arg == "-h")
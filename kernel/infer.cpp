@@ -64,7 +64,11 @@ namespace
 
             "\t-x\n"
             "\t\tDo not trust file headers when determining bounds.  By\n"
-            "\t\tdefault, the headers are considered to be good.\n\n";
+            "\t\tdefault, the headers are considered to be good.\n\n"
+
+            "\t-d\n"
+            "\t\tScan every file and drop dimensions holding a single value\n"
+            "\t\tacross the whole dataset from the inferred schema.\n\n";
     }
 
     std::string getReprojString(const Reprojection* reprojection)
@@ -128,6 +132,7 @@ void Kernel::infer(std::vector<std::string> args)
     std::string user;
     std::string tmpPath("tmp");
     bool trustHeaders(true);
+    bool pruneConstants(false);
 
     std::string output;
 
@@ -204,6 +209,10 @@ void Kernel::infer(std::vector<std::string> args)
         {
             trustHeaders = false;
         }
+        else if (arg == "-d")
+        {
+            pruneConstants = true;
+        }
         else if (arg == "-t")
         {
             if (++a < args.size())
@@ -268,6 +277,7 @@ void Kernel::infer(std::vector<std::string> args)
             cesiumify,
             arbiter.get());
 
+    inference.pruneConstants(pruneConstants);
     inference.go();
 
     if (output.size())
@@ -1,18 +1,28 @@
 #include "gtest/gtest.h"
 #include "config.hpp"
 
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+#include <utility>
+
 #include <pdal/Dimension.hpp>
 #include <pdal/util/FileUtils.hpp>
 #include <pdal/util/Utils.hpp>
 
 #include "entwine/reader/cache.hpp"
+#include "entwine/reader/filter.hpp"
 #include "entwine/reader/reader.hpp"
 #include "entwine/third/arbiter/arbiter.hpp"
+#include "entwine/types/binary-point-table.hpp"
+#include "entwine/types/dir.hpp"
 #include "entwine/tree/builder.hpp"
 #include "entwine/tree/config-parser.hpp"
 #include "entwine/tree/inference.hpp"
 #include "entwine/tree/merger.hpp"
 #include "entwine/util/json.hpp"
+#include "entwine/util/pool.hpp"
+#include "entwine/util/varint.hpp"
 
 #include "octree.hpp"
 
@@ -46,6 +56,52 @@ namespace
         D::Red, D::Green, D::Blue,
         D::PointId, D::OriginId
     };
+
+    // Decode a node of HierarchyTree::toBinary into the form of toJson.
+    Json::Value decodeHierarchy(const char*& pos, const char* end)
+    {
+        Json::Value json;
+        json["n"] = static_cast<Json::UInt64>(extractVarint(pos, end));
+
+        if (pos == end) throw std::runtime_error("Truncated hierarchy");
+        const uint8_t mask(*pos++);
+
+        for (std::size_t i(0); i < dirEnd(); ++i)
+        {
+            if (mask & (1 << i))
+            {
+                json[dirToString(toDir(i))] = decodeHierarchy(pos, end);
+            }
+        }
+
+        return json;
+    }
+
+    Json::Value decodeHierarchy(const std::vector<char>& data)
+    {
+        Json::Value json;
+        const char* pos(data.data());
+        const char* end(pos + data.size());
+
+        if (pos != end) json = decodeHierarchy(pos, end);
+        if (pos != end) throw std::runtime_error("Trailing hierarchy data");
+
+        return json;
+    }
+
+    Json::Value decodeVerticalHierarchy(const std::vector<char>& data)
+    {
+        Json::Value json;
+        const char* pos(data.data());
+        const char* end(pos + data.size());
+
+        while (pos != end)
+        {
+            json.append(static_cast<Json::UInt64>(extractVarint(pos, end)));
+        }
+
+        return json;
+    }
 }
 
 struct Expectations
@@ -181,6 +237,8 @@ TEST_P(BuildTest, Verify)
 
     EXPECT_EQ(meta["compressHierarchy"].asString(), "lzma");
 
+    EXPECT_EQ(meta["chunkStats"].asBool(), config["chunkStats"].asBool());
+
     EXPECT_EQ(
             meta["trustHeaders"].asBool(),
             config.isMember("trustHeaders") ?
@@ -189,7 +247,9 @@ TEST_P(BuildTest, Verify)
     EXPECT_EQ(Version(meta["version"].asString()), currentVersion());
 
     // Verify results against a simple octree implementation.
-    Cache cache(32);
+    Cache::Config cacheConfig;
+    cacheConfig.maxBytes = 64 * 1024 * 1024;
+    Cache cache(cacheConfig);
     Reader r(outPath, cache);
 
     const Delta empty;
@@ -230,6 +290,196 @@ TEST_P(BuildTest, Verify)
 
         ++depth;
     }
+
+    // Binary hierarchies decode to the same counts as their JSON forms.
+    const std::vector<std::pair<Bounds, std::size_t>> hierarchyQueries
+    {
+        { bounds, 0 },
+        { bounds.get(toDir(0)), 0 },
+        { bounds.get(toDir(5)), 2 }
+    };
+
+    for (const auto& h : hierarchyQueries)
+    {
+        const Bounds& q(h.first);
+        const std::size_t begin(h.second);
+
+        const Json::Value json(r.hierarchy(q, begin, depth));
+        EXPECT_EQ(decodeHierarchy(r.hierarchyBinary(q, begin, depth)), json);
+
+        const Json::Value vertical(r.hierarchy(q, begin, depth, true));
+        EXPECT_EQ(
+                decodeVerticalHierarchy(
+                    r.hierarchyBinary(q, begin, depth, true)),
+                vertical);
+    }
+
+    EXPECT_FALSE(r.hierarchy(bounds, 0, depth).isNull());
+
+    // Over everything, vertical hierarchies hold the per-depth counts of our
+    // independently built octree, without any trailing empty depths.
+    for (const std::size_t begin : std::vector<std::size_t> { 0, 2 })
+    {
+        std::vector<std::size_t> counts;
+        for (std::size_t d(begin); d < depth; ++d)
+        {
+            counts.push_back(o.query(d).size());
+        }
+
+        while (counts.size() && !counts.back()) counts.pop_back();
+
+        Json::Value expected;
+        for (const std::size_t n : counts)
+        {
+            expected.append(static_cast<Json::UInt64>(n));
+        }
+
+        EXPECT_EQ(r.hierarchy(bounds, begin, depth, true), expected) <<
+            " Begin: " << begin;
+        EXPECT_EQ(
+                decodeVerticalHierarchy(
+                    r.hierarchyBinary(bounds, begin, depth, true)),
+                expected) << " Begin: " << begin;
+    }
+
+    // Compiled filters must agree with the Filterable tree they came from.
+    const std::vector<std::string> filters
+    {
+        "{ \"Intensity\": { \"$gt\": 100 } }",
+        "{ \"Intensity\": { \"$gte\": 50, \"$lt\": 150.5 } }",
+        "{ \"$or\": [ { \"Classification\": 2 }, "
+            "{ \"ReturnNumber\": { \"$in\": [1, 2] } } ] }",
+        "{ \"$nor\": [ { \"PointSourceId\": { \"$nin\": [0] } }, "
+            "{ \"Intensity\": { \"$lte\": 10 } } ] }",
+        "{ \"$and\": [ { \"Red\": { \"$ne\": 0 } }, { \"$or\": [ "
+            "{ \"Green\": { \"$gt\": 100 } }, "
+            "{ \"Blue\": { \"$lt\": 100 } } ] } ] }"
+    };
+
+    const Metadata& readerMetadata(r.metadata());
+    const Schema& readerSchema(readerMetadata.schema());
+    const Bounds everything(Bounds::everything());
+    const std::vector<char> all(r.query(0, depth));
+    const std::size_t pointSize(readerSchema.pointSize());
+
+    BinaryPointTable table(readerSchema);
+    pdal::PointRef pointRef(table, 0);
+
+    for (const std::string& f : filters)
+    {
+        const Json::Value json(parse(f));
+        const Filter filter(readerMetadata, everything, json, nullptr);
+
+        std::size_t np(0);
+
+        for (std::size_t i(0); i < all.size(); i += pointSize)
+        {
+            const char* data(all.data() + i);
+            table.setPoint(data);
+
+            const bool expected(filter.check(pointRef));
+            ASSERT_EQ(filter.check(data), expected) << f;
+            if (expected) ++np;
+        }
+
+        const std::size_t filtered(
+                r.query(readerSchema, json, 0, depth).size() / pointSize);
+
+        EXPECT_EQ(filtered, np) << f;
+    }
+
+    // With chunk statistics, a filter skips the chunks it rules out entirely
+    // without changing its results.
+    if (config["chunkStats"].asBool())
+    {
+        const Json::Value json(parse("{ \"OriginId\": 0 }"));
+        const Filter filter(readerMetadata, everything, json, nullptr);
+
+        std::vector<char> expected;
+
+        for (std::size_t i(0); i < all.size(); i += pointSize)
+        {
+            const char* data(all.data() + i);
+            table.setPoint(data);
+
+            if (filter.check(pointRef))
+            {
+                expected.insert(expected.end(), data, data + pointSize);
+            }
+        }
+
+        Cache fullCache(cacheConfig);
+        Cache skipCache(cacheConfig);
+        Reader fullReader(outPath, fullCache);
+        Reader skipReader(outPath, skipCache);
+
+        EXPECT_EQ(fullReader.query(0, depth), all);
+        EXPECT_EQ(skipReader.query(readerSchema, json, 0, depth), expected);
+        EXPECT_LT(
+                skipCache.fetchStats().fetches,
+                fullCache.fetchStats().fetches);
+    }
+
+    // Budgeted queries stop at their budget, keeping the coarsest points,
+    // and give up their chunks as soon as they do.
+    const std::size_t half(all.size() / pointSize / 2);
+    auto budgeted(r.getBudgetedQuery(everything, half));
+    const std::vector<char> coarse(budgeted->run());
+
+    EXPECT_TRUE(budgeted->done());
+    EXPECT_EQ(cache.activeBytes(), 0u);
+    EXPECT_LE(budgeted->numPoints(), half);
+    EXPECT_EQ(coarse.size(), budgeted->numPoints() * pointSize);
+    EXPECT_TRUE(std::equal(coarse.begin(), coarse.end(), all.begin()));
+
+    // Budgets plan the deepest depth range whose exact count fits.
+    for (const std::size_t budget : { half / 4, half, half * 2 - 1 })
+    {
+        std::size_t expectedEnd(0);
+        std::size_t total(0);
+
+        while (
+                expectedEnd < depth &&
+                total + o.query(expectedEnd).size() <= budget)
+        {
+            total += o.query(expectedEnd++).size();
+        }
+
+        const auto planned(r.getBudgetedQuery(everything, budget));
+        EXPECT_EQ(planned->depthBegin(), 0u);
+        EXPECT_EQ(planned->depthEnd(), std::max<std::size_t>(expectedEnd, 1))
+            << "Budget: " << budget;
+    }
+
+    // Repeated queries are served from the query cache, unchanged.
+    Cache::Config queryConfig(cacheConfig);
+    queryConfig.maxQueryBytes = all.size();
+    Cache queryCache(queryConfig);
+    Reader cachedReader(outPath, queryCache);
+
+    EXPECT_EQ(cachedReader.query(0, depth), all);
+    EXPECT_EQ(cachedReader.query(0, depth), all);
+
+    const QueryCacheStats stats(queryCache.queryCache().stats());
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.bytes, all.size());
+
+    // Asynchronous queries agree with their blocking counterparts.
+    Pool executor(2, 64);
+    std::promise<std::vector<char>> result;
+
+    r.queryAsync(
+            executor,
+            [&result](std::vector<char> data, std::exception_ptr error)
+            {
+                if (error) result.set_exception(error);
+                else result.set_value(std::move(data));
+            },
+            0,
+            depth);
+
+    EXPECT_EQ(result.get_future().get(), all);
 }
 
 namespace absolute
@@ -272,15 +522,26 @@ namespace absolute
         return json;
     })());
 
+    Json::Value stats(([]()
+    {
+        Json::Value json;
+        json["input"] = test::dataPath() + "ellipsoid-multi-laz";
+        json["output"] = outPath;
+        json["absolute"] = true;
+        json["chunkStats"] = true;
+        return json;
+    })());
+
     Expectations one(single, actualBounds);
     Expectations two(multi, actualBounds);
     Expectations con(continued, actualBounds);
     Expectations sub(subset, actualBounds);
+    Expectations sta(stats, actualBounds);
 
     INSTANTIATE_TEST_CASE_P(
             Absolute,
             BuildTest,
-            testing::Values(one, two, con, sub), );
+            testing::Values(one, two, con, sub, sta), );
 }
 
 namespace scaled
@@ -319,17 +580,27 @@ namespace scaled
         return json;
     })());
 
+    Json::Value stats(([]()
+    {
+        Json::Value json;
+        json["input"] = test::dataPath() + "ellipsoid-multi-laz";
+        json["output"] = outPath;
+        json["chunkStats"] = true;
+        return json;
+    })());
+
     const Delta delta(Scale(.01));
 
     Expectations one(single, actualBounds, delta);
     Expectations two(multi, actualBounds, delta);
     Expectations con(continued, actualBounds, delta);
     Expectations sub(subset, actualBounds, delta);
+    Expectations sta(stats, actualBounds, delta);
 
     INSTANTIATE_TEST_CASE_P(
             Scaled,
             BuildTest,
-            testing::Values(one, two, con, sub), );
+            testing::Values(one, two, con, sub, sta), );
 }
 
 TEST(Build, Kernel)
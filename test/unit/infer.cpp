@@ -1,8 +1,13 @@
 #include "gtest/gtest.h"
 #include "config.hpp"
 
+#include <cstdint>
+#include <cstring>
+
 #include "entwine/tree/inference.hpp"
+#include "entwine/types/constant.hpp"
 #include "entwine/types/reprojection.hpp"
+#include "entwine/util/json.hpp"
 
 using namespace entwine;
 
@@ -176,3 +181,32 @@ TEST(Infer, TrustHeaders)
                 nycCenter + nominalBounds.max()));
 }
 
+
+TEST(Infer, ConstantsAreExact)
+{
+    // Neighboring 64-bit values which share a nearest double.
+    const uint64_t a((1ULL << 53) + 1);
+    const uint64_t b((1ULL << 53) + 2);
+
+    const Constant ca(
+            pdal::Dimension::Type::Unsigned64,
+            reinterpret_cast<const char*>(&a));
+    const Constant cb(
+            pdal::Dimension::Type::Unsigned64,
+            reinterpret_cast<const char*>(&b));
+
+    EXPECT_NE(ca, cb);
+
+    const Constant parsed(parse(toFastString(ca.toJson())));
+    EXPECT_EQ(parsed, ca);
+    EXPECT_EQ(parsed.type(), pdal::Dimension::Type::Unsigned64);
+
+    uint64_t v(0);
+    std::memcpy(&v, parsed.data(), sizeof(v));
+    EXPECT_EQ(v, a);
+
+    // Metadata from earlier versions holds bare doubles.
+    const Constant legacy(Json::Value(1.5));
+    EXPECT_EQ(legacy.type(), pdal::Dimension::Type::Double);
+    EXPECT_EQ(legacy.value(), 1.5);
+}
@@ -0,0 +1,198 @@
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <pdal/Compression.hpp>
+#include <pdal/Dimension.hpp>
+
+#include "entwine/types/schema.hpp"
+#include "entwine/util/compression.hpp"
+#include "entwine/util/point-codec.hpp"
+
+using namespace entwine;
+
+namespace
+{
+    using D = pdal::Dimension::Id;
+    using T = pdal::Dimension::Type;
+
+    const std::size_t numPoints(1000);
+
+    // A record laid out as LAS point format 1, plus RGB for format 3, the
+    // extended fields for format 6, or both for format 7, followed by our
+    // OriginId and PointId.
+    Schema las(const DimList& xyz, const bool rgb, const bool extended)
+    {
+        DimList dims(xyz);
+
+        dims.emplace_back(D::Intensity, T::Unsigned16);
+        dims.emplace_back(D::ReturnNumber, T::Unsigned8);
+        dims.emplace_back(D::NumberOfReturns, T::Unsigned8);
+        dims.emplace_back(D::ScanDirectionFlag, T::Unsigned8);
+        dims.emplace_back(D::EdgeOfFlightLine, T::Unsigned8);
+        dims.emplace_back(D::Classification, T::Unsigned8);
+        dims.emplace_back(D::ScanAngleRank, T::Float);
+        dims.emplace_back(D::UserData, T::Unsigned8);
+        dims.emplace_back(D::PointSourceId, T::Unsigned16);
+        dims.emplace_back(D::GpsTime, T::Double);
+
+        if (rgb)
+        {
+            dims.emplace_back(D::Red, T::Unsigned16);
+            dims.emplace_back(D::Green, T::Unsigned16);
+            dims.emplace_back(D::Blue, T::Unsigned16);
+        }
+
+        if (extended)
+        {
+            dims.emplace_back(D::ScanChannel, T::Unsigned8);
+            dims.emplace_back(D::ClassFlags, T::Unsigned8);
+        }
+
+        dims.emplace_back(D::OriginId, T::Unsigned32);
+        dims.emplace_back(D::PointId, T::Unsigned32);
+
+        return Schema(dims);
+    }
+
+    // Every layout with a specialized coder.
+    std::vector<Schema> specializedSchemas()
+    {
+        const std::vector<DimList> spatial
+        {
+            {
+                DimInfo(D::X, T::Signed32),
+                DimInfo(D::Y, T::Signed32),
+                DimInfo(D::Z, T::Signed32)
+            },
+            {
+                DimInfo(D::X, T::Signed32),
+                DimInfo(D::Y, T::Signed32),
+                DimInfo(D::Z, T::Signed16)
+            },
+            {
+                DimInfo(D::X, T::Double),
+                DimInfo(D::Y, T::Double),
+                DimInfo(D::Z, T::Double)
+            }
+        };
+
+        std::vector<Schema> schemas;
+
+        for (const DimList& xyz : spatial)
+        {
+            schemas.push_back(las(xyz, false, false));  // Format 1.
+            schemas.push_back(las(xyz, true, false));   // Format 3.
+            schemas.push_back(las(xyz, false, true));   // Format 6.
+            schemas.push_back(las(xyz, true, true));    // Format 7.
+        }
+
+        return schemas;
+    }
+
+    // Slowly varying values, like those of neighboring points, with some
+    // noise in the low bytes.
+    std::vector<char> makePoints(const Schema& schema)
+    {
+        const std::size_t pointSize(schema.pointSize());
+        std::vector<char> points(numPoints * pointSize);
+
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> noise(0, 15);
+
+        for (std::size_t i(0); i < points.size(); ++i)
+        {
+            const std::size_t point(i / pointSize);
+            const std::size_t byte(i % pointSize);
+            points[i] = static_cast<char>(point * byte / 7 + noise(gen));
+        }
+
+        return points;
+    }
+
+    std::vector<char> encode(const Schema& schema, const std::vector<char>& in)
+    {
+        CompressionStream stream(in.size());
+        auto encoder(PointEncoder::create(stream, schema));
+        encoder->compress(in.data(), in.size());
+        encoder->done();
+        return *stream.data();
+    }
+
+    std::vector<char> encodeGeneric(
+            const Schema& schema,
+            const std::vector<char>& in)
+    {
+        CompressionStream stream(in.size());
+        pdal::LazPerfCompressor<CompressionStream> compressor(
+                stream,
+                schema.pdalLayout().dimTypes());
+        compressor.compress(in.data(), in.size());
+        compressor.done();
+        return *stream.data();
+    }
+
+    std::vector<char> decode(
+            const Schema& schema,
+            const std::vector<char>& in,
+            const std::size_t size)
+    {
+        std::vector<char> out(size);
+        DecompressionStream stream(in);
+        auto decoder(PointDecoder::create(stream, schema));
+        decoder->decompress(out.data(), out.size());
+        return out;
+    }
+
+    std::vector<char> decodeGeneric(
+            const Schema& schema,
+            const std::vector<char>& in,
+            const std::size_t size)
+    {
+        std::vector<char> out(size);
+        DecompressionStream stream(in);
+        pdal::LazPerfDecompressor<DecompressionStream> decompressor(
+                stream,
+                schema.pdalLayout().dimTypes());
+        decompressor.decompress(out.data(), out.size());
+        return out;
+    }
+}
+
+TEST(PointCodec, SpecializedMatchesGeneric)
+{
+    for (const Schema& schema : specializedSchemas())
+    {
+        const std::vector<char> points(makePoints(schema));
+
+        const std::vector<char> specialized(encode(schema, points));
+        const std::vector<char> generic(encodeGeneric(schema, points));
+
+        // Both coders produce the same stream, so each can decode the other.
+        EXPECT_EQ(specialized, generic) << schema;
+        EXPECT_EQ(decodeGeneric(schema, specialized, points.size()), points);
+        EXPECT_EQ(decode(schema, generic, points.size()), points);
+        EXPECT_EQ(decode(schema, specialized, points.size()), points);
+    }
+}
+
+TEST(PointCodec, GenericFallback)
+{
+    // Not a LAS point format, so this is coded generically.
+    const Schema schema(
+            DimList
+            {
+                DimInfo(D::X, T::Double),
+                DimInfo(D::Y, T::Double),
+                DimInfo(D::Z, T::Double),
+                DimInfo(D::Intensity, T::Unsigned16)
+            });
+
+    const std::vector<char> points(makePoints(schema));
+    const std::vector<char> encoded(encode(schema, points));
+
+    EXPECT_EQ(encoded, encodeGeneric(schema, points));
+    EXPECT_EQ(decode(schema, encoded, points.size()), points);
+}